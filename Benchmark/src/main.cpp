@@ -0,0 +1,210 @@
+// Compares the fragment throughput of the uber quad shader against its variants specialized for each element type.
+// Every scene is a stack of large overlapping quads drawn back to front, so that the frames are bound by fragment shading rather than by the CPU.
+// Usage: QuadShaderBenchmark [frames per measurement]
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "FlameUI.h"
+#include "renderer/SortKey.h"
+
+namespace {
+    struct Scene
+    {
+        const char*        Name;
+        /// Element types of the layers of the scene, from the back to the front
+        std::vector<float> Layers;
+    };
+
+    struct Measurement
+    {
+        double   GpuMilliseconds = 0.0;
+        uint32_t DrawCalls = 0;
+    };
+
+    constexpr uint32_t c_LayerCount = 96;
+    constexpr uint32_t c_WarmupFrames = 20;
+
+    /// Quad shader element types which don't need any resources besides the theme
+    const float c_ElementTypes[] = {
+        FL_ELEMENT_TYPE_GENERAL_INDEX, FL_ELEMENT_TYPE_PANEL_INDEX, FL_ELEMENT_TYPE_BUTTON_INDEX, FL_ELEMENT_TYPE_CIRCLE_INDEX, FL_ELEMENT_TYPE_ROUNDED_RECT_INDEX,
+        FL_ELEMENT_TYPE_RING_INDEX, FL_ELEMENT_TYPE_LINE_INDEX, FL_ELEMENT_TYPE_CAPSULE_INDEX, FL_ELEMENT_TYPE_PANEL_SHADOW_INDEX
+    };
+    constexpr uint32_t c_ElementTypeCount = sizeof(c_ElementTypes) / sizeof(c_ElementTypes[0]);
+
+    std::vector<Scene> CreateScenes()
+    {
+        std::vector<Scene> scenes;
+        // One element type only, the best case for the uber shader as every fragment takes the same branch
+        scenes.push_back({ "flat quads", std::vector<float>(c_LayerCount, FL_ELEMENT_TYPE_GENERAL_INDEX) });
+        scenes.push_back({ "rounded rects", std::vector<float>(c_LayerCount, FL_ELEMENT_TYPE_ROUNDED_RECT_INDEX) });
+        scenes.push_back({ "panel shadows", std::vector<float>(c_LayerCount, FL_ELEMENT_TYPE_PANEL_SHADOW_INDEX) });
+
+        // Every element type in blocks of layers, so that the variants need only a few draw calls
+        Scene grouped{ "mixed, grouped", {} };
+        for (uint32_t i = 0; i < c_LayerCount; i++)
+            grouped.Layers.push_back(c_ElementTypes[i * c_ElementTypeCount / c_LayerCount]);
+        scenes.push_back(grouped);
+
+        // Every layer a different element type, the worst case for the variants which need a draw call per layer
+        Scene interleaved{ "mixed, interleaved", {} };
+        for (uint32_t i = 0; i < c_LayerCount; i++)
+            interleaved.Layers.push_back(c_ElementTypes[i % c_ElementTypeCount]);
+        scenes.push_back(interleaved);
+        return scenes;
+    }
+
+    void SubmitScene(const Scene& scene, const glm::vec2& quadDimensions)
+    {
+        for (uint32_t i = 0; i < (uint32_t)scene.Layers.size(); i++)
+        {
+            // Every layer is in front of the previous one, so that no fragment is rejected by the depth test
+            float z = FlameUI::GetDrawDepth(FL_DRAW_LAYER_PANELS, i, FL_DRAW_SUBLAYER_PANEL);
+            glm::vec3 position = { (float)(i % 5) * 8.0f - 16.0f, (float)(i % 3) * 8.0f - 8.0f, z };
+            glm::vec4 color = { 0.2f + 0.6f * (float)(i % 4) / 3.0f, 0.4f, 0.8f, 0.5f };
+            float halfExtent = std::min(quadDimensions.x, quadDimensions.y) / 2.0f;
+
+            float elementType = scene.Layers[i];
+            if (elementType == FL_ELEMENT_TYPE_CIRCLE_INDEX)
+                FlameUI::Renderer::AddCircle(position, halfExtent, color);
+            else if (elementType == FL_ELEMENT_TYPE_ROUNDED_RECT_INDEX)
+                FlameUI::Renderer::AddRoundedRect(position, quadDimensions, 24.0f, color);
+            else if (elementType == FL_ELEMENT_TYPE_RING_INDEX)
+                FlameUI::Renderer::AddRing(position, halfExtent, 16.0f, color);
+            else if (elementType == FL_ELEMENT_TYPE_LINE_INDEX)
+                FlameUI::Renderer::AddLine(glm::vec2(position) - quadDimensions / 2.0f, glm::vec2(position) + quadDimensions / 2.0f, z, 64.0f, color);
+            else if (elementType == FL_ELEMENT_TYPE_CAPSULE_INDEX)
+                FlameUI::Renderer::AddCapsule(glm::vec2(position) - quadDimensions / 2.0f, glm::vec2(position) + quadDimensions / 2.0f, z, 64.0f, color);
+            else if (elementType == FL_ELEMENT_TYPE_PANEL_SHADOW_INDEX)
+                FlameUI::Renderer::AddPanelShadow(position, quadDimensions);
+            else if (elementType == FL_ELEMENT_TYPE_BUTTON_INDEX)
+                FlameUI::Renderer::AddStyledQuad(position, quadDimensions, FL_STYLE_BUTTON_INDEX, elementType);
+            else
+                FlameUI::Renderer::AddQuad(position, quadDimensions, color, elementType, FlameUI::UnitType::PIXEL_UNITS, i % 2);
+        }
+    }
+
+    /// Draws the scene for `frameCount` frames and returns the average GPU time and draw calls of a frame
+    Measurement MeasureScene(GLFWwindow* window, const Scene& scene, const glm::vec2& quadDimensions, uint32_t frameCount)
+    {
+        std::vector<uint32_t> queryIds(frameCount);
+        glGenQueries((GLsizei)frameCount, queryIds.data());
+
+        Measurement measurement;
+        for (uint32_t frame = 0; frame < c_WarmupFrames + frameCount; frame++)
+        {
+            bool isMeasured = frame >= c_WarmupFrames;
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (isMeasured)
+                glBeginQuery(GL_TIME_ELAPSED, queryIds[frame - c_WarmupFrames]);
+
+            FlameUI::Renderer::Begin();
+            SubmitScene(scene, quadDimensions);
+            FlameUI::Renderer::End();
+
+            if (isMeasured)
+            {
+                glEndQuery(GL_TIME_ELAPSED);
+                measurement.DrawCalls += FlameUI::Renderer::GetQuadDrawCallCount();
+            }
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        // The results are only read back once all the frames are submitted, so that reading them doesn't stall the measured frames
+        for (uint32_t queryId : queryIds)
+        {
+            GLuint64 elapsedNanoseconds = 0;
+            glGetQueryObjectui64v(queryId, GL_QUERY_RESULT, &elapsedNanoseconds);
+            measurement.GpuMilliseconds += (double)elapsedNanoseconds / 1e6;
+        }
+        glDeleteQueries((GLsizei)frameCount, queryIds.data());
+
+        measurement.GpuMilliseconds /= frameCount;
+        measurement.DrawCalls /= frameCount;
+        return measurement;
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    uint32_t frameCount = argc > 1 ? (uint32_t)std::max(std::atoi(argv[1]), 1) : 200;
+
+    if (!glfwInit())
+    {
+        std::printf("Failed to Initialize GLFW!\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_COCOA_RETINA_FRAMEBUFFER, GLFW_TRUE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(1280, 720, "FlameUI Quad Shader Benchmark", NULL, NULL);
+    if (!window)
+    {
+        std::printf("Failed to create the window!\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    // Frames are presented as fast as they are drawn, so that vsync doesn't hide the difference between the strategies
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::printf("Failed to initialize GLAD\n");
+        return 1;
+    }
+
+    FlameUI::ThemeInfo themeInfo{};
+    themeInfo.panelBgColor = { 0.06f, 0.06f, 0.06f, 1.0f };
+    themeInfo.borderColor = { 0.43f, 0.43f, 0.50f, 0.50f };
+    themeInfo.panelTitleBarInactiveColor = { 0.04f, 0.04f, 0.04f, 1.00f };
+    themeInfo.panelTitleBarActiveColor = { 0.16f, 0.29f, 0.48f, 1.00f };
+    themeInfo.buttonColor = { 0.26f, 0.59f, 0.98f, 0.40f };
+    themeInfo.buttonHoveredColor = { 0.26f, 0.59f, 0.98f, 1.00f };
+    themeInfo.buttonPressedColor = { 0.06f, 0.53f, 0.98f, 1.00f };
+    themeInfo.windowBgColor = { 50.0f / 255.0f, 50.0f / 255.0f, 50.0f / 255.0f, 1.0f };
+    themeInfo.panelCornerRadius = 12.0f;
+    themeInfo.panelShadowBlurSigma = 8.0f;
+
+    FlameUI::RendererInitInfo rendererInitInfo{};
+    rendererInitInfo.userWindow = window;
+    rendererInitInfo.enableFontRendering = false;
+    rendererInitInfo.themeInfo = &themeInfo;
+    FlameUI::Renderer::Init(rendererInitInfo);
+
+    // The quads cover most of the viewport, the fragment count of a layer is only an estimate, as the SDF primitives discard their transparent fragments
+    glm::vec2 viewportSize = FlameUI::Renderer::GetViewportSize();
+    glm::vec2 contentScale = FlameUI::Renderer::GetWindowContentScale();
+    glm::vec2 quadDimensions = { 0.8f * viewportSize.x / contentScale.x, 0.8f * viewportSize.y / contentScale.y };
+    double fragmentsPerLayer = (double)(0.8f * viewportSize.x) * (double)(0.8f * viewportSize.y);
+
+    std::printf("%s, %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+    std::printf("%u layers of %.0fx%.0f pixels, %u frames per measurement\n\n", c_LayerCount, 0.8f * viewportSize.x, 0.8f * viewportSize.y, frameCount);
+    std::printf("%-20s | %-20s | %10s | %10s | %14s\n", "Scene", "Strategy", "GPU ms", "Draws", "GFragments/s");
+
+    const FlameUI::QuadShaderStrategy strategies[] = { FlameUI::QuadShaderStrategy::UBER_SHADER, FlameUI::QuadShaderStrategy::SPECIALIZED_VARIANTS };
+    for (const Scene& scene : CreateScenes())
+    {
+        for (FlameUI::QuadShaderStrategy strategy : strategies)
+        {
+            FlameUI::Renderer::SetQuadShaderStrategy(strategy);
+            Measurement measurement = MeasureScene(window, scene, quadDimensions, frameCount);
+
+            double fragmentsPerSecond = fragmentsPerLayer * scene.Layers.size() / (measurement.GpuMilliseconds / 1e3);
+            const char* strategyName = strategy == FlameUI::QuadShaderStrategy::UBER_SHADER ? "uber shader" : "specialized variants";
+            std::printf("%-20s | %-20s | %10.3f | %10u | %14.2f\n", scene.Name, strategyName, measurement.GpuMilliseconds, measurement.DrawCalls, fragmentsPerSecond / 1e9);
+        }
+    }
+
+    FlameUI::Renderer::CleanUp();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
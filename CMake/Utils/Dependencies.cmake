@@ -1,5 +1,8 @@
+# Worker threads are used for font loading
+find_package(Threads REQUIRED)
+
 # OpenGL Helper Libs
-set(FL_GRAPHICS_LIBS glfw Glad freetype msdfgen-core msdfgen-ext)
+set(FL_GRAPHICS_LIBS glfw Glad freetype msdfgen-core msdfgen-ext Threads::Threads)
 
 if(APPLE)
     # Inbuilt mac frameworks required for GLFW
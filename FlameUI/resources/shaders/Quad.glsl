@@ -1,13 +1,18 @@
 #shader vertex
 #version 410 core
 
+// Per-instance attributes, one set for every quad
 layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec4 a_Color;
-layout (location = 2) in vec2 a_Texture_UV;
+layout (location = 1) in vec2 a_QuadDimensions;
+layout (location = 2) in vec4 a_Color;
 layout (location = 3) in float a_TextureIndex;
-layout (location = 4) in vec2 a_QuadDimensions;
-layout (location = 5) in float a_ElementTypeIndex;
-layout (location = 6) in float a_IsPanelActive;
+layout (location = 4) in float a_ElementTypeIndex;
+layout (location = 5) in float a_IsPanelActive;
+layout (location = 6) in float a_StyleIndex;
+layout (location = 7) in vec4 a_ClipRect;
+layout (location = 8) in float a_TextureLayer;
+layout (location = 9) in vec2 a_TextureUVScale;
+layout (location = 10) in float a_ShapeParam;
 
 out vec4 v_Color;
 out float v_TextureIndex;
@@ -15,22 +20,58 @@ out vec2 v_Texture_UV;
 out vec2 v_QuadDimensions;
 out float v_ElementTypeIndex;
 out float v_IsPanelActive;
+out float v_TextureLayer;
+out vec2 v_TextureUVScale;
+out float v_ShapeParam;
 
 layout (std140) uniform Camera
 {
     mat4 ViewProjectionMatrix;
 } u_Camera;
 
+// Uploaded only when the theme changes, the size of StyleColors has to match FL_STYLE_COUNT
+layout (std140) uniform Theme
+{
+    vec4 PanelBgColor;
+    vec4 PanelTitleBarActiveColor;
+    vec4 PanelTitleBarInactiveColor;
+    vec4 BorderColor;
+    vec4 StyleColors[4];
+    float TitleBarHeight;
+    float PanelBorderWidth;
+    float PanelCornerRadius;
+    float PanelShadowBlurSigma;
+    vec4 PanelShadowColor;
+    vec2 PanelShadowOffset;
+} u_Theme;
+
+// Corners of the unit quad, in the order of the two triangles that make up the quad
+const vec2 c_QuadCorners[6] = vec2[6](
+    vec2(-0.5,  0.5), vec2( 0.5,  0.5), vec2( 0.5, -0.5),
+    vec2( 0.5, -0.5), vec2(-0.5, -0.5), vec2(-0.5,  0.5)
+);
+
 void main()
 {
-    v_Color = a_Color;
+    vec2 corner = c_QuadCorners[gl_VertexID];
+
+    // Style 0 means the quad has its own color, every other style takes its color from the theme
+    int styleIndex = int(a_StyleIndex);
+    v_Color = styleIndex == 0 ? a_Color : u_Theme.StyleColors[styleIndex];
     v_TextureIndex = a_TextureIndex;
-    v_Texture_UV = a_Texture_UV;
     v_QuadDimensions = a_QuadDimensions;
     v_ElementTypeIndex = a_ElementTypeIndex;
     v_IsPanelActive = a_IsPanelActive;
+    v_TextureLayer = a_TextureLayer;
+    v_TextureUVScale = a_TextureUVScale;
+    v_ShapeParam = a_ShapeParam;
 
-    gl_Position = u_Camera.ViewProjectionMatrix * vec4(a_Position, 1.0);
+    // The quad is axis aligned, so clamping its corners to the clip rectangle (l, r, b, t) clips it exactly without discarding any fragments.
+    // The texture coordinates follow the clamped corners, so that the visible part of the quad looks the same as before clipping
+    vec2 position = clamp(a_Position.xy + corner * a_QuadDimensions, a_ClipRect.xz, a_ClipRect.yw);
+    v_Texture_UV = (position - a_Position.xy) / a_QuadDimensions + 0.5;
+
+    gl_Position = u_Camera.ViewProjectionMatrix * vec4(position, a_Position.z, 1.0);
 }
 
 #shader fragment
@@ -44,57 +85,211 @@ in vec2 v_Texture_UV;
 in vec2 v_QuadDimensions;
 in float v_ElementTypeIndex;
 in float v_IsPanelActive;
+in float v_TextureLayer;
+in vec2 v_TextureUVScale;
+in float v_ShapeParam;
 
-uniform float u_TitleBarHeight;
-uniform vec4 u_PanelTitleBarActiveColor;
-uniform vec4 u_PanelTitleBarInactiveColor;
-uniform vec4 u_PanelBgColor;
-uniform vec4 u_BorderColor;
+layout (std140) uniform Theme
+{
+    vec4 PanelBgColor;
+    vec4 PanelTitleBarActiveColor;
+    vec4 PanelTitleBarInactiveColor;
+    vec4 BorderColor;
+    vec4 StyleColors[4];
+    float TitleBarHeight;
+    float PanelBorderWidth;
+    float PanelCornerRadius;
+    float PanelShadowBlurSigma;
+    vec4 PanelShadowColor;
+    vec2 PanelShadowOffset;
+} u_Theme;
 
-uniform sampler2D u_TextureSamplers[16];
+// Every slot holds a texture array with all the textures of one size class, the size has to match MAX_TEXTURE_SLOTS
+uniform sampler2DArray u_TextureSamplers[16];
+// Fragments drawn by the current pass, has to match QuadAlphaPass: 0 for all of them, 1 for the opaque ones only and 2 for the translucent ones only
+uniform int u_AlphaPass;
 
-vec4 GetPanelColor()
+vec4 SampleTextureLayer(sampler2DArray textureArray, vec2 uv)
 {
-    // vec4 color = v_Color;
-    vec4 color = u_PanelBgColor;
-    
-    float normalizedTitleBarHeight = u_TitleBarHeight / v_QuadDimensions.y;
-    if (v_Texture_UV.y > 1.0 - normalizedTitleBarHeight)
+    // Textures smaller than their size class only fill the bottom left of the layer, the coordinates are kept half a texel inside of it,
+    // so that the filtering doesn't blend in the unused texels next to the texture
+    vec2 halfTexel = 0.5 / vec2(textureSize(textureArray, 0).xy);
+    vec2 layerUV = clamp(uv * v_TextureUVScale, halfTexel, v_TextureUVScale - halfTexel);
+    return texture(textureArray, vec3(layerUV, v_TextureLayer));
+}
+
+// Indexing an array of samplers with an index that differs between quads isn't allowed in GLSL 4.10, so every slot is sampled using a constant index
+#define SAMPLE_TEXTURE_SLOT(slot) case slot: return SampleTextureLayer(u_TextureSamplers[slot], uv)
+
+vec4 SampleTexture(int slot, vec2 uv)
+{
+    switch (slot)
     {
-        if (v_IsPanelActive == 1.0)
-            color = u_PanelTitleBarActiveColor;
-        else
-            color = u_PanelTitleBarInactiveColor;
+        SAMPLE_TEXTURE_SLOT(0);  SAMPLE_TEXTURE_SLOT(1);  SAMPLE_TEXTURE_SLOT(2);  SAMPLE_TEXTURE_SLOT(3);
+        SAMPLE_TEXTURE_SLOT(4);  SAMPLE_TEXTURE_SLOT(5);  SAMPLE_TEXTURE_SLOT(6);  SAMPLE_TEXTURE_SLOT(7);
+        SAMPLE_TEXTURE_SLOT(8);  SAMPLE_TEXTURE_SLOT(9);  SAMPLE_TEXTURE_SLOT(10); SAMPLE_TEXTURE_SLOT(11);
+        SAMPLE_TEXTURE_SLOT(12); SAMPLE_TEXTURE_SLOT(13); SAMPLE_TEXTURE_SLOT(14); SAMPLE_TEXTURE_SLOT(15);
+    }
+    return vec4(1.0);
+}
+
+// Pixels of padding around the signed distance field primitives and steps per pixel of their shape parameter, have to match FL_SHAPE_AA_PADDING and FL_SHAPE_PARAM_SCALE
+const float c_ShapePadding = 1.0;
+const float c_ShapeParamScale = 16.0;
+
+float RoundedBoxDistance(vec2 p, vec2 halfSize, float radius)
+{
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+float SegmentDistance(vec2 p, vec2 a, vec2 b)
+{
+    vec2 pa = p - a, ba = b - a;
+    float h = clamp(dot(pa, ba) / max(dot(ba, ba), 1e-6), 0.0, 1.0);
+    return length(pa - ba * h);
+}
+
+// Signed distance in pixels from the edge of the primitive to `p`, which is relative to the center of the quad, negative inside of the primitive
+float GetShapeDistance(int elementType, vec2 p)
+{
+    vec2 halfSize = max(v_QuadDimensions * 0.5 - c_ShapePadding, 0.0);
+    float shapeParam = abs(v_ShapeParam) / c_ShapeParamScale;
+    float radius = min(halfSize.x, halfSize.y);
+
+    switch (elementType)
+    {
+        case 3: return length(p) - radius;
+        case 4: return RoundedBoxDistance(p, halfSize, min(shapeParam, radius));
+        case 5: return abs(length(p) - radius + shapeParam * 0.5) - shapeParam * 0.5;
+    }
+
+    // Lines and capsules run between two opposite corners of the quad shrunk by half their thickness, the sign of the shape parameter picks the diagonal
+    vec2 end = max(halfSize - shapeParam * 0.5, 0.0);
+    if (v_ShapeParam < 0.0)
+        end.y = -end.y;
+    if (elementType == 7)
+        return SegmentDistance(p, -end, end) - shapeParam * 0.5;
+
+    float halfLength = length(end);
+    vec2 direction = halfLength > 0.0 ? end / halfLength : vec2(1.0, 0.0);
+    return RoundedBoxDistance(vec2(dot(p, direction), dot(p, vec2(-direction.y, direction.x))), vec2(halfLength, shapeParam * 0.5), 0.0);
+}
+
+// Polynomial approximation of the error function with a maximum error of 5e-4, which is plenty for a shadow
+vec2 Erf(vec2 x)
+{
+    vec2 s = sign(x), a = abs(x);
+    x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;
+    x *= x;
+    return s - s / (x * x);
+}
+
+float Gaussian(float x, float sigma)
+{
+    return exp(-(x * x) / (2.0 * sigma * sigma)) / (2.5066283 * sigma);
+}
+
+// Integral of the gaussian along x over the row of the rounded box at height y, which is closed form using the error function
+float RoundedBoxShadowRow(float x, float y, float sigma, float radius, vec2 halfSize)
+{
+    float delta = min(halfSize.y - radius - abs(y), 0.0);
+    float curved = halfSize.x - radius + sqrt(max(0.0, radius * radius - delta * delta));
+    vec2 integral = 0.5 + 0.5 * Erf((x + vec2(-curved, curved)) * (0.7071068 / sigma));
+    return integral.y - integral.x;
+}
+
+// Fraction of a rounded box centered at the origin that covers `p` once it is blurred by a gaussian, the blur is separable for the straight edges,
+// so only the blur along y has to be sampled, and 4 samples within 3 sigma of `p` are enough to hide the corners being approximated
+float RoundedBoxShadow(vec2 p, vec2 halfSize, float sigma, float radius)
+{
+    float low = p.y - halfSize.y, high = p.y + halfSize.y;
+    float start = clamp(-3.0 * sigma, low, high), end = clamp(3.0 * sigma, low, high);
+    float sampleSpacing = (end - start) / 4.0;
+    float y = start + sampleSpacing * 0.5;
+    float value = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        value += RoundedBoxShadowRow(p.x, p.y - y, sigma, radius, halfSize) * Gaussian(y, sigma) * sampleSpacing;
+        y += sampleSpacing;
     }
+    return value;
+}
 
-    // Code to add border of the given width and color
-    float border_width = 0.002;
+vec4 GetPanelShadowColor(vec2 p, float antialiasingWidth)
+{
+    // The shadow quad is the panel grown by 3 sigma on every side and moved by the shadow offset
+    float sigma = u_Theme.PanelShadowBlurSigma;
+    vec2 panelHalfSize = max(v_QuadDimensions * 0.5 - 3.0 * sigma, 0.0);
+    float radius = min(u_Theme.PanelCornerRadius, min(panelHalfSize.x, panelHalfSize.y));
 
-    float normalizedBorderWidthX = border_width / v_QuadDimensions.x;
-    float normalizedBorderWidthY = border_width / v_QuadDimensions.y;
+    // The shadow isn't drawn under the panel itself, so that it doesn't show through translucent panels
+    float panelCoverage = clamp(0.5 - RoundedBoxDistance(p + u_Theme.PanelShadowOffset, panelHalfSize, radius) / antialiasingWidth, 0.0, 1.0);
+    float shadow = RoundedBoxShadow(p, panelHalfSize, sigma, radius) * (1.0 - panelCoverage);
+    return vec4(v_Color.rgb, v_Color.a * shadow);
+}
 
-    float maxX = 1.0 - normalizedBorderWidthX;
-    float minX = normalizedBorderWidthX;
-    float maxY = 1.0 - normalizedBorderWidthY;
-    float minY = normalizedBorderWidthY;
+vec4 GetPanelColor(vec2 p, float antialiasingWidth)
+{
+    // vec4 color = v_Color;
+    vec4 color = u_Theme.PanelBgColor;
 
-    if (v_Texture_UV.x >= maxX || v_Texture_UV.x <= minX || v_Texture_UV.y >= maxY || v_Texture_UV.y <= minY)
-        color = u_BorderColor;
+    vec2 halfSize = v_QuadDimensions * 0.5;
+    if (p.y > halfSize.y - u_Theme.TitleBarHeight)
+    {
+        if (v_IsPanelActive == 1.0)
+            color = u_Theme.PanelTitleBarActiveColor;
+        else
+            color = u_Theme.PanelTitleBarInactiveColor;
+    }
 
+    // The border is the band of the given width in pixels inside the edge of the rounded box, antialiased on both sides like the edge itself
+    float distance = RoundedBoxDistance(p, halfSize, min(u_Theme.PanelCornerRadius, min(halfSize.x, halfSize.y)));
+    float border = clamp(0.5 + (distance + u_Theme.PanelBorderWidth) / antialiasingWidth, 0.0, 1.0);
+    color = mix(color, u_Theme.BorderColor, border);
+    color.a *= clamp(0.5 - distance / antialiasingWidth, 0.0, 1.0);
     return color;
 }
 
 void main()
 {
-    switch (int(v_ElementTypeIndex))
+    // Derivatives are undefined in non-uniform control flow, so the size of a pixel is taken before branching on the element type.
+    // Fading the edges over one physical pixel keeps the primitives antialiased the same way at any scale
+    vec2 shapePosition = (v_Texture_UV - 0.5) * v_QuadDimensions;
+    vec2 pixelSize = fwidth(shapePosition);
+    float antialiasingWidth = max(max(pixelSize.x, pixelSize.y), 1e-4);
+
+    // Specialized variants are compiled with the element type defined, which folds the switch down to the one element type at compile time
+#ifdef FL_ELEMENT_TYPE_VARIANT
+    const int elementType = FL_ELEMENT_TYPE_VARIANT;
+#else
+    int elementType = int(v_ElementTypeIndex);
+#endif
+    switch (elementType)
     {
         case 0: 
             if (v_TextureIndex == -1)
                 FragColor = v_Color;
             else 
-                FragColor = texture(u_TextureSamplers[int(v_TextureIndex)], v_Texture_UV);
+                FragColor = SampleTexture(int(v_TextureIndex), v_Texture_UV);
             break;
-        case 1: FragColor = GetPanelColor(); break;
+        case 1: FragColor = GetPanelColor(shapePosition, antialiasingWidth); break;
         case 2: FragColor = v_Color; break;
+        case 3: case 4: case 5: case 6: case 7:
+        {
+            float coverage = clamp(0.5 - GetShapeDistance(elementType, shapePosition) / antialiasingWidth, 0.0, 1.0);
+            FragColor = vec4(v_Color.rgb, v_Color.a * coverage);
+            break;
+        }
+        case 8: FragColor = GetPanelShadowColor(shapePosition, antialiasingWidth); break;
+        // Unknown element types are only caught by an assert in debug builds, they are drawn as flat quads rather than with an undefined color
+        default: FragColor = v_Color; break;
     }
+
+    // Fully transparent fragments, e.g. the padding around the primitives and the faded out shadows, must not write depth, which would hide what is drawn behind them afterwards
+    if (FragColor.a <= 0.0)
+        discard;
+    // Drawing the opaque and the translucent fragments in separate passes lets the translucent ones skip writing depth
+    if ((u_AlphaPass == 1 && FragColor.a < 1.0) || (u_AlphaPass == 2 && FragColor.a >= 1.0))
+        discard;
 }
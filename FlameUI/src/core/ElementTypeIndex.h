@@ -1,4 +1,14 @@
 #pragma once
 #define FL_ELEMENT_TYPE_GENERAL_INDEX 0.0f
 #define FL_ELEMENT_TYPE_PANEL_INDEX 1.0f
-#define FL_ELEMENT_TYPE_BUTTON_INDEX 2.0f
\ No newline at end of file
+#define FL_ELEMENT_TYPE_BUTTON_INDEX 2.0f
+/// Signed distance field primitives, shaded analytically by Quad.glsl using the `shape_param` of the quad instance
+#define FL_ELEMENT_TYPE_CIRCLE_INDEX 3.0f
+#define FL_ELEMENT_TYPE_ROUNDED_RECT_INDEX 4.0f
+#define FL_ELEMENT_TYPE_RING_INDEX 5.0f
+#define FL_ELEMENT_TYPE_LINE_INDEX 6.0f
+#define FL_ELEMENT_TYPE_CAPSULE_INDEX 7.0f
+/// Drop shadow of the panel quad, shaded analytically by Quad.glsl using the shadow of the theme
+#define FL_ELEMENT_TYPE_PANEL_SHADOW_INDEX 8.0f
+/// Number of element types, one specialized variant of the quad shader is compiled for each of them
+#define FL_ELEMENT_TYPE_COUNT 9
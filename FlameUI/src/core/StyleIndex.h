@@ -0,0 +1,8 @@
+#pragma once
+/// Quads with this style are drawn with their own color, all the other styles take their color from the theme uniform buffer
+#define FL_STYLE_NONE_INDEX 0
+#define FL_STYLE_BUTTON_INDEX 1
+#define FL_STYLE_BUTTON_HOVERED_INDEX 2
+#define FL_STYLE_BUTTON_PRESSED_INDEX 3
+/// Number of styles, has to match the size of `StyleColors` in the Theme uniform block of Quad.glsl
+#define FL_STYLE_COUNT 4
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Framebuffer.h"
 #include "core/Core.h"
+#include "renderer/GLState.h"
 #include <glad/glad.h>
 
 namespace FlameUI {
@@ -7,10 +8,10 @@ namespace FlameUI {
         : m_FramebufferId(0), m_ColorAttachmentId(0), m_DepthAttachmentId(0), m_FramebufferSize(width, height)
     {
         glGenFramebuffers(1, &m_FramebufferId);
-        glBindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
 
         glGenTextures(1, &m_ColorAttachmentId);
-        glBindTexture(GL_TEXTURE_2D, m_ColorAttachmentId);
+        GLState::BindTexture(0, GL_TEXTURE_2D, m_ColorAttachmentId);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_FramebufferSize.x, m_FramebufferSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -19,14 +20,14 @@ namespace FlameUI {
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorAttachmentId, 0);
 
         glGenTextures(1, &m_DepthAttachmentId);
-        glBindTexture(GL_TEXTURE_2D, m_DepthAttachmentId);
+        GLState::BindTexture(0, GL_TEXTURE_2D, m_DepthAttachmentId);
 
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_FramebufferSize.x, m_FramebufferSize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_DepthAttachmentId, 0);
 
         FL_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
     void Framebuffer::OnUpdate()
@@ -36,13 +37,16 @@ namespace FlameUI {
             glDeleteFramebuffers(1, &m_FramebufferId);
             glDeleteTextures(1, &m_ColorAttachmentId);
             glDeleteTextures(1, &m_DepthAttachmentId);
+            GLState::OnFramebufferDeleted(m_FramebufferId);
+            GLState::OnTextureDeleted(m_ColorAttachmentId);
+            GLState::OnTextureDeleted(m_DepthAttachmentId);
         }
 
         glGenFramebuffers(1, &m_FramebufferId);
-        glBindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
 
         glGenTextures(1, &m_ColorAttachmentId);
-        glBindTexture(GL_TEXTURE_2D, m_ColorAttachmentId);
+        GLState::BindTexture(0, GL_TEXTURE_2D, m_ColorAttachmentId);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_FramebufferSize.x, m_FramebufferSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -51,14 +55,14 @@ namespace FlameUI {
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorAttachmentId, 0);
 
         glGenTextures(1, &m_DepthAttachmentId);
-        glBindTexture(GL_TEXTURE_2D, m_DepthAttachmentId);
+        GLState::BindTexture(0, GL_TEXTURE_2D, m_DepthAttachmentId);
 
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_FramebufferSize.x, m_FramebufferSize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_DepthAttachmentId, 0);
 
         FL_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
     void Framebuffer::SetFramebufferSize(float width, float height)
@@ -68,13 +72,13 @@ namespace FlameUI {
 
     void Framebuffer::Bind() const
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
-        glViewport(0, 0, m_FramebufferSize.x, m_FramebufferSize.y);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, m_FramebufferId);
+        GLState::Viewport(0, 0, m_FramebufferSize.x, m_FramebufferSize.y);
     }
 
     void Framebuffer::Unbind() const
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
     Framebuffer::~Framebuffer()
@@ -82,5 +86,8 @@ namespace FlameUI {
         glDeleteTextures(1, &m_ColorAttachmentId);
         glDeleteTextures(1, &m_DepthAttachmentId);
         glDeleteFramebuffers(1, &m_FramebufferId);
+        GLState::OnTextureDeleted(m_ColorAttachmentId);
+        GLState::OnTextureDeleted(m_DepthAttachmentId);
+        GLState::OnFramebufferDeleted(m_FramebufferId);
     }
 }
\ No newline at end of file
@@ -15,6 +15,9 @@ namespace FlameUI {
         void     SetFramebufferSize(float width, float height);
         /// Returns the opengl texture Id of texture made using the Framebuffer object
         uint32_t GetColorAttachmentId() const { return m_ColorAttachmentId; };
+        /// Returns the opengl Id of the Framebuffer object, e.g. to use it as the source of a blit
+        uint32_t GetFramebufferId() const { return m_FramebufferId; }
+        glm::vec2 GetFramebufferSize() const { return m_FramebufferSize; }
         /// Binds the Framebuffer object
         void     Bind() const;
         /// Unbinds the Framebuffer object
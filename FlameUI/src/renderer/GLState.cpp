@@ -0,0 +1,221 @@
+#include "GLState.h"
+#include "core/Core.h"
+
+namespace FlameUI {
+    template<typename T, size_t N>
+    static std::array<T, N> MakeFilledArray(T value)
+    {
+        std::array<T, N> array;
+        array.fill(value);
+        return array;
+    }
+
+    uint32_t                                         GLState::s_ProgramId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_VertexArrayId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_ArrayBufferId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_UniformBufferId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_ActiveTextureUnit = GLState::s_UnknownState;
+    std::array<uint32_t, MAX_SHADOWED_TEXTURE_UNITS> GLState::s_Texture2DIds = MakeFilledArray<uint32_t, MAX_SHADOWED_TEXTURE_UNITS>(GLState::s_UnknownState);
+    std::array<uint32_t, MAX_SHADOWED_TEXTURE_UNITS> GLState::s_Texture2DArrayIds = MakeFilledArray<uint32_t, MAX_SHADOWED_TEXTURE_UNITS>(GLState::s_UnknownState);
+    uint32_t                                         GLState::s_ReadFramebufferId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_DrawFramebufferId = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_IsBlendEnabled = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_IsDepthTestEnabled = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_IsScissorTestEnabled = GLState::s_UnknownState;
+    uint32_t                                         GLState::s_IsDepthMaskEnabled = GLState::s_UnknownState;
+    std::array<uint32_t, 2>                          GLState::s_BlendFunc = MakeFilledArray<uint32_t, 2>(GLState::s_UnknownState);
+    std::array<int32_t, 4>                           GLState::s_Viewport = MakeFilledArray<int32_t, 4>(INT32_MIN);
+    std::array<int32_t, 4>                           GLState::s_Scissor = MakeFilledArray<int32_t, 4>(INT32_MIN);
+    GLStateCounters                                  GLState::s_Counters;
+
+    template<typename T>
+    bool GLState::ShouldIssue(T& shadowedValue, const T& value)
+    {
+        if (shadowedValue == value)
+        {
+            s_Counters.SkippedCalls++;
+            return false;
+        }
+        shadowedValue = value;
+        s_Counters.IssuedCalls++;
+        return true;
+    }
+
+    void GLState::UseProgram(uint32_t programId)
+    {
+        if (ShouldIssue(s_ProgramId, programId))
+            glUseProgram(programId);
+    }
+
+    void GLState::BindVertexArray(uint32_t vertexArrayId)
+    {
+        if (ShouldIssue(s_VertexArrayId, vertexArrayId))
+            glBindVertexArray(vertexArrayId);
+    }
+
+    void GLState::BindBuffer(GLenum target, uint32_t bufferId)
+    {
+        switch (target)
+        {
+            case GL_ARRAY_BUFFER:
+                if (ShouldIssue(s_ArrayBufferId, bufferId))
+                    glBindBuffer(target, bufferId);
+                break;
+            case GL_UNIFORM_BUFFER:
+                if (ShouldIssue(s_UniformBufferId, bufferId))
+                    glBindBuffer(target, bufferId);
+                break;
+            default:
+                // e.g. GL_ELEMENT_ARRAY_BUFFER, which is part of the vertex array state
+                s_Counters.IssuedCalls++;
+                glBindBuffer(target, bufferId);
+                break;
+        }
+    }
+
+    void GLState::BindBufferRange(GLenum target, uint32_t index, uint32_t bufferId, GLintptr offset, GLsizeiptr size)
+    {
+        // The indexed binding points are set up once, so only the side effect on the generic binding is shadowed
+        s_Counters.IssuedCalls++;
+        glBindBufferRange(target, index, bufferId, offset, size);
+        if (target == GL_UNIFORM_BUFFER)
+            s_UniformBufferId = bufferId;
+    }
+
+    void GLState::BindTexture(uint32_t unit, GLenum target, uint32_t textureId)
+    {
+        uint32_t* shadowedTextureId = nullptr;
+        if (unit < MAX_SHADOWED_TEXTURE_UNITS)
+        {
+            if (target == GL_TEXTURE_2D)
+                shadowedTextureId = &s_Texture2DIds[unit];
+            else if (target == GL_TEXTURE_2D_ARRAY)
+                shadowedTextureId = &s_Texture2DArrayIds[unit];
+        }
+
+        // The unit is made active even if the texture is already bound to it, as the caller may go on to modify the bound texture
+        if (ShouldIssue(s_ActiveTextureUnit, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+
+        if (shadowedTextureId && !ShouldIssue(*shadowedTextureId, textureId))
+            return;
+        if (!shadowedTextureId)
+            s_Counters.IssuedCalls++;
+        glBindTexture(target, textureId);
+    }
+
+    void GLState::BindFramebuffer(GLenum target, uint32_t framebufferId)
+    {
+        switch (target)
+        {
+            case GL_FRAMEBUFFER:
+                if (s_ReadFramebufferId == framebufferId && s_DrawFramebufferId == framebufferId)
+                    s_Counters.SkippedCalls++;
+                else
+                {
+                    s_Counters.IssuedCalls++;
+                    s_ReadFramebufferId = s_DrawFramebufferId = framebufferId;
+                    glBindFramebuffer(target, framebufferId);
+                }
+                break;
+            case GL_READ_FRAMEBUFFER:
+                if (ShouldIssue(s_ReadFramebufferId, framebufferId))
+                    glBindFramebuffer(target, framebufferId);
+                break;
+            case GL_DRAW_FRAMEBUFFER:
+                if (ShouldIssue(s_DrawFramebufferId, framebufferId))
+                    glBindFramebuffer(target, framebufferId);
+                break;
+            default:
+                FL_ASSERT(0, "Invalid framebuffer target {0}!", target);
+                break;
+        }
+    }
+
+    void GLState::SetCapability(GLenum capability, bool isEnabled)
+    {
+        uint32_t* shadowedState = nullptr;
+        switch (capability)
+        {
+            case GL_BLEND:        shadowedState = &s_IsBlendEnabled; break;
+            case GL_DEPTH_TEST:   shadowedState = &s_IsDepthTestEnabled; break;
+            case GL_SCISSOR_TEST: shadowedState = &s_IsScissorTestEnabled; break;
+            default:
+                FL_ASSERT(0, "Capability {0} isn't shadowed by GLState!", capability);
+                return;
+        }
+
+        if (!ShouldIssue(*shadowedState, (uint32_t)isEnabled))
+            return;
+        if (isEnabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    void GLState::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+    {
+        if (ShouldIssue(s_BlendFunc, std::array<uint32_t, 2>{ sourceFactor, destinationFactor }))
+            glBlendFunc(sourceFactor, destinationFactor);
+    }
+
+    void GLState::DepthMask(bool isEnabled)
+    {
+        if (ShouldIssue(s_IsDepthMaskEnabled, (uint32_t)isEnabled))
+            glDepthMask(isEnabled ? GL_TRUE : GL_FALSE);
+    }
+
+    void GLState::Viewport(int32_t x, int32_t y, int32_t width, int32_t height)
+    {
+        if (ShouldIssue(s_Viewport, std::array<int32_t, 4>{ x, y, width, height }))
+            glViewport(x, y, width, height);
+    }
+
+    void GLState::Scissor(int32_t x, int32_t y, int32_t width, int32_t height)
+    {
+        if (ShouldIssue(s_Scissor, std::array<int32_t, 4>{ x, y, width, height }))
+            glScissor(x, y, width, height);
+    }
+
+    void GLState::OnTextureDeleted(uint32_t textureId)
+    {
+        for (uint32_t unit = 0; unit < MAX_SHADOWED_TEXTURE_UNITS; unit++)
+        {
+            if (s_Texture2DIds[unit] == textureId)
+                s_Texture2DIds[unit] = 0;
+            if (s_Texture2DArrayIds[unit] == textureId)
+                s_Texture2DArrayIds[unit] = 0;
+        }
+    }
+
+    void GLState::OnFramebufferDeleted(uint32_t framebufferId)
+    {
+        if (s_ReadFramebufferId == framebufferId)
+            s_ReadFramebufferId = 0;
+        if (s_DrawFramebufferId == framebufferId)
+            s_DrawFramebufferId = 0;
+    }
+
+    void GLState::OnBufferDeleted(uint32_t bufferId)
+    {
+        if (s_ArrayBufferId == bufferId)
+            s_ArrayBufferId = 0;
+        if (s_UniformBufferId == bufferId)
+            s_UniformBufferId = 0;
+    }
+
+    void GLState::Invalidate()
+    {
+        s_ProgramId = s_VertexArrayId = s_UnknownState;
+        s_ArrayBufferId = s_UniformBufferId = s_UnknownState;
+        s_ActiveTextureUnit = s_UnknownState;
+        s_Texture2DIds.fill(s_UnknownState);
+        s_Texture2DArrayIds.fill(s_UnknownState);
+        s_ReadFramebufferId = s_DrawFramebufferId = s_UnknownState;
+        s_IsBlendEnabled = s_IsDepthTestEnabled = s_IsScissorTestEnabled = s_UnknownState;
+        s_IsDepthMaskEnabled = s_UnknownState;
+        s_BlendFunc.fill(s_UnknownState);
+        s_Viewport.fill(INT32_MIN);
+        s_Scissor.fill(INT32_MIN);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <glad/glad.h>
+
+/// Number of texture units whose bindings are shadowed, binds to higher units are always issued
+#define MAX_SHADOWED_TEXTURE_UNITS 32
+
+namespace FlameUI {
+    /// Number of OpenGL state changes which were issued to the driver and which were skipped because the state was already set
+    struct GLStateCounters
+    {
+        uint64_t IssuedCalls = 0;
+        uint64_t SkippedCalls = 0;
+    };
+
+    /// Thin wrapper over the OpenGL state changes used by FlameUI, which shadows the current state and skips the calls that wouldn't change it.
+    /// All binds of FlameUI go through this class, code outside of it which changes the same state has to call `Invalidate()` afterwards
+    class GLState
+    {
+    public:
+        static void UseProgram(uint32_t programId);
+        static void BindVertexArray(uint32_t vertexArrayId);
+        /// Binds a buffer to GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER, other targets are passed through without shadowing
+        static void BindBuffer(GLenum target, uint32_t bufferId);
+        /// Binds a range of a uniform buffer to an indexed binding point, which also binds it to the generic GL_UNIFORM_BUFFER binding
+        static void BindBufferRange(GLenum target, uint32_t index, uint32_t bufferId, GLintptr offset, GLsizeiptr size);
+        /// Binds a GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY texture to a texture unit, and makes that unit the active one
+        static void BindTexture(uint32_t unit, GLenum target, uint32_t textureId);
+        /// Binds a framebuffer to GL_FRAMEBUFFER, GL_READ_FRAMEBUFFER or GL_DRAW_FRAMEBUFFER
+        static void BindFramebuffer(GLenum target, uint32_t framebufferId);
+        /// Enables or disables GL_BLEND, GL_DEPTH_TEST or GL_SCISSOR_TEST
+        static void SetCapability(GLenum capability, bool isEnabled);
+        static void BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+        /// Enables or disables depth writes, which also affects clearing the depth buffer
+        static void DepthMask(bool isEnabled);
+        static void Viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+        static void Scissor(int32_t x, int32_t y, int32_t width, int32_t height);
+
+        /// Deleting a bound object makes OpenGL bind 0 in its place, these keep the shadowed state in sync with that
+        static void OnTextureDeleted(uint32_t textureId);
+        static void OnFramebufferDeleted(uint32_t framebufferId);
+        static void OnBufferDeleted(uint32_t bufferId);
+
+        /// Forgets the shadowed state, so that the next call of every kind is issued, e.g. after code outside of FlameUI changed the OpenGL state
+        static void Invalidate();
+        static const GLStateCounters& GetCounters() { return s_Counters; }
+        static void ResetCounters() { s_Counters = GLStateCounters{}; }
+    private:
+        /// Returns true if the call has to be issued, updating `shadowedValue` and the counters
+        template<typename T>
+        static bool ShouldIssue(T& shadowedValue, const T& value);
+    private:
+        /// Value of the shadowed state before it is known, no valid object id or state has this value
+        static constexpr uint32_t s_UnknownState = UINT32_MAX;
+
+        static uint32_t                                             s_ProgramId;
+        static uint32_t                                             s_VertexArrayId;
+        static uint32_t                                             s_ArrayBufferId, s_UniformBufferId;
+        static uint32_t                                             s_ActiveTextureUnit;
+        /// Textures bound to each unit, for the GL_TEXTURE_2D and the GL_TEXTURE_2D_ARRAY targets
+        static std::array<uint32_t, MAX_SHADOWED_TEXTURE_UNITS>     s_Texture2DIds, s_Texture2DArrayIds;
+        static uint32_t                                             s_ReadFramebufferId, s_DrawFramebufferId;
+        static uint32_t                                             s_IsBlendEnabled, s_IsDepthTestEnabled, s_IsScissorTestEnabled;
+        static uint32_t                                             s_IsDepthMaskEnabled;
+        static std::array<uint32_t, 2>                              s_BlendFunc;
+        static std::array<int32_t, 4>                               s_Viewport, s_Scissor;
+        static GLStateCounters                                      s_Counters;
+    };
+}
@@ -0,0 +1,151 @@
+#include "GlyphAtlas.h"
+#include <cstring>
+#include <glad/glad.h>
+#include "core/Core.h"
+#include "renderer/GLState.h"
+
+namespace FlameUI {
+    /// Empty texels left between glyphs, so that linear filtering doesn't bleed neighbouring glyphs in
+    static constexpr uint32_t s_GlyphPadding = 1;
+
+    ShelfPacker::ShelfPacker(uint32_t width, uint32_t height)
+        : m_Width(width), m_Height(height), m_NextShelfY(0)
+    {
+    }
+
+    bool ShelfPacker::Pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+    {
+        if (width > m_Width)
+            return false;
+
+        // Pick the shelf which wastes the least height, out of the ones which still have room for the rectangle
+        Shelf* bestShelf = nullptr;
+        for (auto& shelf : m_Shelves)
+        {
+            if (shelf.Height >= height && shelf.CursorX + width <= m_Width)
+            {
+                if (!bestShelf || shelf.Height < bestShelf->Height)
+                    bestShelf = &shelf;
+            }
+        }
+
+        if (!bestShelf)
+        {
+            if (m_NextShelfY + height > m_Height)
+                return false;
+            bestShelf = &m_Shelves.emplace_back(Shelf{ m_NextShelfY, height, 0 });
+            m_NextShelfY += height;
+        }
+
+        x = bestShelf->CursorX;
+        y = bestShelf->Y;
+        bestShelf->CursorX += width;
+        return true;
+    }
+
+    void ShelfPacker::Reset()
+    {
+        m_Shelves.clear();
+        m_NextShelfY = 0;
+    }
+
+    GlyphPageBuilder::GlyphPageBuilder(uint32_t pageSize)
+        : m_PageSize(pageSize), m_Packer(pageSize, pageSize), m_Pixels(3 * (size_t)pageSize * pageSize, 0)
+    {
+    }
+
+    bool GlyphPageBuilder::AddGlyph(uint32_t width, uint32_t height, const uint8_t* pixels, glm::vec2& uvMin, glm::vec2& uvMax)
+    {
+        uint32_t x, y;
+        if (!m_Packer.Pack(width + s_GlyphPadding, height + s_GlyphPadding, x, y))
+            return false;
+
+        for (uint32_t row = 0; row < height; row++)
+            memcpy(&m_Pixels[3 * ((size_t)(y + row) * m_PageSize + x)], &pixels[3 * (size_t)row * width], 3 * (size_t)width);
+
+        uvMin = { (float)x / m_PageSize, (float)y / m_PageSize };
+        uvMax = { (float)(x + width) / m_PageSize, (float)(y + height) / m_PageSize };
+        return true;
+    }
+
+    GlyphAtlas::GlyphAtlas(uint32_t pageSize, uint32_t pageCount)
+        : m_TextureId(0), m_PageSize(pageSize), m_Pages(pageCount)
+    {
+        for (auto& page : m_Pages)
+            page.Packer = ShelfPacker(pageSize, pageSize);
+
+        glGenTextures(1, &m_TextureId);
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, m_TextureId);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // All the pages are allocated up front, the glyphs are uploaded into them as they get generated
+        GL_CHECK_ERROR(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, pageSize, pageSize, pageCount, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr));
+    }
+
+    bool GlyphAtlas::AddGlyph(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t& page, glm::vec2& uvMin, glm::vec2& uvMax)
+    {
+        uint32_t x, y;
+        for (page = 0; page < m_Pages.size(); page++)
+        {
+            if (!m_Pages[page].IsPinned && m_Pages[page].Packer.Pack(width + s_GlyphPadding, height + s_GlyphPadding, x, y))
+                break;
+        }
+        if (page == m_Pages.size())
+            return false;
+
+        if (width && height)
+        {
+            GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, m_TextureId);
+            // RGB8 rows are not 4 byte aligned for every width
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            GL_CHECK_ERROR(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, page, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels));
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        uvMin = { (float)x / m_PageSize, (float)y / m_PageSize };
+        uvMax = { (float)(x + width) / m_PageSize, (float)(y + height) / m_PageSize };
+        return true;
+    }
+
+    void GlyphAtlas::UploadPage(uint32_t page, const uint8_t* pixels)
+    {
+        FL_ASSERT(page < m_Pages.size(), "Glyph atlas page {0} is out of range!", page);
+
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, m_TextureId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GL_CHECK_ERROR(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, page, m_PageSize, m_PageSize, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        m_Pages[page].IsPinned = true;
+    }
+
+    int32_t GlyphAtlas::EvictLeastRecentlyUsedPage(uint64_t frameIndex)
+    {
+        int32_t leastRecentlyUsedPage = -1;
+        for (uint32_t page = 0; page < m_Pages.size(); page++)
+        {
+            if (m_Pages[page].IsPinned || m_Pages[page].LastUsedFrame >= frameIndex)
+                continue;
+            if (leastRecentlyUsedPage == -1 || m_Pages[page].LastUsedFrame < m_Pages[leastRecentlyUsedPage].LastUsedFrame)
+                leastRecentlyUsedPage = (int32_t)page;
+        }
+
+        // The old texels are simply overwritten by the glyphs packed into the page next
+        if (leastRecentlyUsedPage != -1)
+            m_Pages[leastRecentlyUsedPage].Packer.Reset();
+        return leastRecentlyUsedPage;
+    }
+
+    GlyphAtlas::~GlyphAtlas()
+    {
+        if (m_TextureId)
+        {
+            glDeleteTextures(1, &m_TextureId);
+            GLState::OnTextureDeleted(m_TextureId);
+        }
+    }
+}
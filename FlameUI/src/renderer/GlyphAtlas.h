@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace FlameUI {
+    /// Packs rectangles into horizontal shelves of a fixed size area, a new shelf is opened below the last one when no shelf has space left
+    class ShelfPacker
+    {
+    public:
+        ShelfPacker(uint32_t width = 0, uint32_t height = 0);
+        ~ShelfPacker() = default;
+
+        /// Finds space for a rectangle of the given size, returns false if the area is full
+        bool Pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+        /// Removes all the shelves, making the whole area available again
+        void Reset();
+    private:
+        struct Shelf
+        {
+            uint32_t Y, Height, CursorX;
+        };
+    private:
+        uint32_t           m_Width, m_Height;
+        /// The y coordinate where the next shelf will be opened
+        uint32_t           m_NextShelfY;
+        std::vector<Shelf> m_Shelves;
+    };
+
+    /// Packs MSDF glyph bitmaps into the CPU copy of a single RGB8 atlas page, used to build the pinned page of preloaded glyphs before it is uploaded using `GlyphAtlas::UploadPage()`
+    class GlyphPageBuilder
+    {
+    public:
+        GlyphPageBuilder(uint32_t pageSize);
+        ~GlyphPageBuilder() = default;
+
+        /// Copies the RGB8 glyph bitmap into the page and outputs its texture coordinates, returns false if the page is full
+        bool     AddGlyph(uint32_t width, uint32_t height, const uint8_t* pixels, glm::vec2& uvMin, glm::vec2& uvMax);
+        /// Returns the page pixels in RGB8 format, with the first row being the bottom of the page
+        const std::vector<uint8_t>& GetPixels() const { return m_Pixels; }
+        uint32_t GetPageSize() const { return m_PageSize; }
+    private:
+        uint32_t             m_PageSize;
+        ShelfPacker          m_Packer;
+        std::vector<uint8_t> m_Pixels;
+    };
+
+    /// Class which stores the MSDF glyph bitmaps of a font in the fixed size RGB8 pages of an OpenGL array texture.
+    /// Pinned pages are never evicted, the other pages are filled on demand and evicted in least recently used order once all of them are full
+    class GlyphAtlas
+    {
+    public:
+        GlyphAtlas(uint32_t pageSize, uint32_t pageCount);
+        ~GlyphAtlas();
+
+        /// Packs the RGB8 glyph bitmap into one of the unpinned pages and uploads it, returns false if all of them are full
+        bool     AddGlyph(uint32_t width, uint32_t height, const uint8_t* pixels, uint32_t& page, glm::vec2& uvMin, glm::vec2& uvMax);
+        /// Uploads RGB8 pixels covering a whole page and pins it, e.g. straight from a memory-mapped cache file
+        void     UploadPage(uint32_t page, const uint8_t* pixels);
+        /// Marks the page as used in the given frame, pages which haven't been used for the longest time are evicted first
+        void     Touch(uint32_t page, uint64_t frameIndex) { m_Pages[page].LastUsedFrame = frameIndex; }
+        /// Empties the least recently used unpinned page so that new glyphs can be packed into it, returns the index of the page or -1 if there is none to evict.
+        /// Pages used in `frameIndex` are never evicted, as glyphs queued for drawing in that frame may still sample them
+        int32_t  EvictLeastRecentlyUsedPage(uint64_t frameIndex);
+        /// Returns the opengl texture Id of the `GL_TEXTURE_2D_ARRAY` texture, every page is one layer of it
+        uint32_t GetTextureId() const { return m_TextureId; }
+        uint32_t GetPageSize() const { return m_PageSize; }
+        uint32_t GetPageCount() const { return (uint32_t)m_Pages.size(); }
+    private:
+        struct Page
+        {
+            ShelfPacker Packer;
+            uint64_t    LastUsedFrame = 0;
+            bool        IsPinned = false;
+        };
+    private:
+        uint32_t          m_TextureId;
+        uint32_t          m_PageSize;
+        std::vector<Page> m_Pages;
+    };
+}
@@ -0,0 +1,112 @@
+#include "GlyphAtlasCache.h"
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include "core/Core.h"
+
+namespace FlameUI {
+    GlyphAtlasCache::GlyphAtlasCache(const std::string& filePath, const GlyphAtlasCacheKey& key)
+        : m_File(filePath), m_Header(nullptr)
+    {
+        static_assert(sizeof(Header) == 48 && sizeof(GlyphEntry) == 48, "The cache file layout must not depend on the compiler's padding");
+
+        if (!m_File.IsOpen() || m_File.GetSize() < sizeof(Header))
+            return;
+
+        const Header* header = (const Header*)m_File.GetData();
+        if (memcmp(header->Magic, s_Magic, sizeof(s_Magic)) || header->Version != s_Version)
+            return;
+
+        if (header->FontContentHash != key.FontContentHash || header->PixelRange != key.PixelRange || header->BorderWidth != key.BorderWidth)
+            return;
+
+        size_t expectedSize = sizeof(Header) + header->GlyphCount * sizeof(GlyphEntry) + 3 * (size_t)header->AtlasWidth * header->AtlasHeight;
+        if (m_File.GetSize() != expectedSize)
+            return;
+
+        m_Header = header;
+    }
+
+    float    GlyphAtlasCache::GetAscenderY() const { return m_Header->AscenderY; }
+    float    GlyphAtlasCache::GetDescenderY() const { return m_Header->DescenderY; }
+    uint32_t GlyphAtlasCache::GetAtlasWidth() const { return m_Header->AtlasWidth; }
+    uint32_t GlyphAtlasCache::GetAtlasHeight() const { return m_Header->AtlasHeight; }
+
+    std::vector<std::pair<uint32_t, flame::character>> GlyphAtlasCache::GetCharacters() const
+    {
+        std::vector<std::pair<uint32_t, flame::character>> characters;
+        characters.reserve(m_Header->GlyphCount);
+
+        const GlyphEntry* entries = (const GlyphEntry*)(m_File.GetData() + sizeof(Header));
+        for (uint32_t i = 0; i < m_Header->GlyphCount; i++)
+        {
+            const GlyphEntry& entry = entries[i];
+            flame::character character = {
+                0,
+                { entry.Size[0], entry.Size[1] },
+                { entry.Bearing[0], entry.Bearing[1] },
+                entry.Advance,
+                { entry.UVMin[0], entry.UVMin[1] },
+                { entry.UVMax[0], entry.UVMax[1] }
+            };
+            characters.emplace_back(entry.Codepoint, character);
+        }
+        return characters;
+    }
+
+    const uint8_t* GlyphAtlasCache::GetAtlasPixels() const
+    {
+        return m_File.GetData() + sizeof(Header) + m_Header->GlyphCount * sizeof(GlyphEntry);
+    }
+
+    bool GlyphAtlasCache::Write(const std::string& filePath, const GlyphAtlasCacheKey& key, float ascenderY, float descenderY, const std::unordered_map<uint32_t, flame::character>& characters, const GlyphPageBuilder& page)
+    {
+        const std::vector<uint8_t>& pixels = page.GetPixels();
+
+        std::error_code errorCode;
+        std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), errorCode);
+
+        // Write to a temporary file first, so that a crash while writing never leaves behind a truncated cache file
+        std::string temporaryFilePath = filePath + ".tmp";
+        std::ofstream stream(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+            return false;
+
+        Header header{};
+        memcpy(header.Magic, s_Magic, sizeof(s_Magic));
+        header.Version = s_Version;
+        header.FontContentHash = key.FontContentHash;
+        header.PixelRange = key.PixelRange;
+        header.BorderWidth = key.BorderWidth;
+        header.AscenderY = ascenderY;
+        header.DescenderY = descenderY;
+        header.AtlasWidth = page.GetPageSize();
+        header.AtlasHeight = page.GetPageSize();
+        header.GlyphCount = (uint32_t)characters.size();
+        stream.write((const char*)&header, sizeof(Header));
+
+        for (const auto& [codepoint, character] : characters)
+        {
+            GlyphEntry entry{};
+            entry.Advance = character.advance;
+            entry.Codepoint = codepoint;
+            entry.Size[0] = character.size.x;
+            entry.Size[1] = character.size.y;
+            entry.Bearing[0] = character.bearing.x;
+            entry.Bearing[1] = character.bearing.y;
+            entry.UVMin[0] = character.uvMin.x;
+            entry.UVMin[1] = character.uvMin.y;
+            entry.UVMax[0] = character.uvMax.x;
+            entry.UVMax[1] = character.uvMax.y;
+            stream.write((const char*)&entry, sizeof(GlyphEntry));
+        }
+
+        stream.write((const char*)pixels.data(), pixels.size());
+        stream.close();
+        if (stream.fail())
+            return false;
+
+        std::filesystem::rename(temporaryFilePath, filePath, errorCode);
+        return !errorCode;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "ui/Text.h"
+#include "utils/MappedFile.h"
+#include "renderer/GlyphAtlas.h"
+
+namespace FlameUI {
+    /// Everything the generated glyph atlas depends on, a cache file generated with a different key is regenerated
+    struct GlyphAtlasCacheKey
+    {
+        /// FNV-1a hash of the bytes of the font file
+        uint64_t FontContentHash;
+        float    PixelRange;
+        float    BorderWidth;
+    };
+
+    /// Versioned binary file which stores the pixels of the pinned glyph atlas page together with the metrics of all of its glyphs,
+    /// so that later startups can upload the atlas straight from the memory-mapped file instead of generating the glyphs again
+    class GlyphAtlasCache
+    {
+    public:
+        /// Memory-maps the cache file, `IsValid()` returns false if it is missing, corrupt, of another version or generated with another key
+        GlyphAtlasCache(const std::string& filePath, const GlyphAtlasCacheKey& key);
+        ~GlyphAtlasCache() = default;
+
+        bool           IsValid() const { return m_Header != nullptr; }
+        float          GetAscenderY() const;
+        float          GetDescenderY() const;
+        uint32_t       GetAtlasWidth() const;
+        uint32_t       GetAtlasHeight() const;
+        /// Returns the metrics of all the cached glyphs, the `textureId` of each of them is left as 0
+        std::vector<std::pair<uint32_t, flame::character>> GetCharacters() const;
+        /// Returns the RGB8 atlas pixels, pointing directly into the mapped file
+        const uint8_t* GetAtlasPixels() const;
+
+        /// Writes the page pixels and the metrics of the glyphs in it to the cache file, returns false if the file couldn't be written
+        static bool Write(const std::string& filePath, const GlyphAtlasCacheKey& key, float ascenderY, float descenderY, const std::unordered_map<uint32_t, flame::character>& characters, const GlyphPageBuilder& page);
+    private:
+        struct Header
+        {
+            char     Magic[4];
+            uint32_t Version;
+            uint64_t FontContentHash;
+            float    PixelRange;
+            float    BorderWidth;
+            float    AscenderY;
+            float    DescenderY;
+            uint32_t AtlasWidth;
+            uint32_t AtlasHeight;
+            uint32_t GlyphCount;
+            uint32_t Reserved;
+        };
+        struct GlyphEntry
+        {
+            double   Advance;
+            uint32_t Codepoint;
+            float    Size[2];
+            float    Bearing[2];
+            float    UVMin[2];
+            float    UVMax[2];
+            uint32_t Reserved;
+        };
+        /// Has to be incremented every time the layout of the file or the way glyphs are generated changes
+        constexpr static uint32_t s_Version = 2;
+        constexpr static char     s_Magic[4] = { 'F', 'L', 'G', 'A' };
+    private:
+        MappedFile    m_File;
+        const Header* m_Header;
+    };
+}
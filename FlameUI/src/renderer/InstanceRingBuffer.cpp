@@ -0,0 +1,122 @@
+#include "InstanceRingBuffer.h"
+#include <cstring>
+#include "core/Core.h"
+#include "renderer/GLState.h"
+
+namespace FlameUI {
+    /// Time waited for a region fence in a single call, in nanoseconds, the wait is repeated until the fence is signaled
+    static constexpr GLuint64 s_FenceWaitTimeout = 1000000;
+
+    InstanceRingBuffer::InstanceRingBuffer(uint32_t instanceSize, uint32_t regionCapacity)
+        : m_BufferId(0), m_InstanceSize(instanceSize), m_RegionCapacity(regionCapacity), m_MappedData(nullptr), m_RegionIndex(0), m_RegionInstanceCount(0)
+    {
+        m_RegionFences.fill(nullptr);
+        CreateBuffer();
+    }
+
+    InstanceRingBuffer::~InstanceRingBuffer()
+    {
+        DestroyBuffer();
+    }
+
+    void InstanceRingBuffer::CreateBuffer()
+    {
+        glGenBuffers(1, &m_BufferId);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, m_BufferId);
+
+        size_t regionSize = (size_t)m_RegionCapacity * m_InstanceSize;
+        if (GLAD_GL_VERSION_4_4)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, regionSize * INSTANCE_RING_REGION_COUNT, nullptr, flags);
+            m_MappedData = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize * INSTANCE_RING_REGION_COUNT, flags);
+            FL_ASSERT(m_MappedData, "Failed to persistently map the instance buffer!");
+        }
+        else
+            glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+
+        m_RegionIndex = 0;
+        m_RegionInstanceCount = 0;
+    }
+
+    void InstanceRingBuffer::DestroyBuffer()
+    {
+        for (auto& fence : m_RegionFences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        if (m_MappedData)
+        {
+            GLState::BindBuffer(GL_ARRAY_BUFFER, m_BufferId);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            m_MappedData = nullptr;
+        }
+
+        glDeleteBuffers(1, &m_BufferId);
+        GLState::OnBufferDeleted(m_BufferId);
+        m_BufferId = 0;
+    }
+
+    uint32_t InstanceRingBuffer::Upload(const void* instances, uint32_t instanceCount)
+    {
+        FL_ASSERT(instanceCount <= m_RegionCapacity, "Uploading {0} instances to a ring with regions of {1} instances!", instanceCount, m_RegionCapacity);
+
+        if (!m_MappedData)
+        {
+            // Orphaning hands the storage the GPU may still be reading to the driver, so the upload never waits for it
+            GLState::BindBuffer(GL_ARRAY_BUFFER, m_BufferId);
+            glBufferData(GL_ARRAY_BUFFER, (size_t)m_RegionCapacity * m_InstanceSize, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, (size_t)instanceCount * m_InstanceSize, instances);
+            return 0;
+        }
+
+        // A frame which flushes more than a region holds moves on to the next region early
+        if (m_RegionInstanceCount + instanceCount > m_RegionCapacity)
+            AdvanceRegion();
+
+        uint32_t firstInstance = m_RegionIndex * m_RegionCapacity + m_RegionInstanceCount;
+        std::memcpy(m_MappedData + (size_t)firstInstance * m_InstanceSize, instances, (size_t)instanceCount * m_InstanceSize);
+        m_RegionInstanceCount += instanceCount;
+        return firstInstance;
+    }
+
+    void InstanceRingBuffer::OnFrameEnd()
+    {
+        if (m_MappedData && m_RegionInstanceCount)
+            AdvanceRegion();
+    }
+
+    void InstanceRingBuffer::Resize(uint32_t regionCapacity)
+    {
+        // Buffer storage is immutable, so the buffer is replaced, OpenGL keeps the old one alive until the GPU is done with it
+        DestroyBuffer();
+        m_RegionCapacity = regionCapacity;
+        CreateBuffer();
+    }
+
+    void InstanceRingBuffer::AdvanceRegion()
+    {
+        m_RegionFences[m_RegionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_RegionIndex = (m_RegionIndex + 1) % INSTANCE_RING_REGION_COUNT;
+        m_RegionInstanceCount = 0;
+
+        GLsync& fence = m_RegionFences[m_RegionIndex];
+        if (!fence)
+            return;
+
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            FL_WARN("Waiting for the GPU to finish reading region {0} of the instance ring", m_RegionIndex);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, s_FenceWaitTimeout);
+        }
+        FL_ASSERT(result != GL_WAIT_FAILED, "Waiting for an instance buffer fence failed!");
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
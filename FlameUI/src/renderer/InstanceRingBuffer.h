@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <glad/glad.h>
+
+/// Number of frame regions of a persistently mapped ring, the CPU fills one while the GPU may still be reading the other two
+#define INSTANCE_RING_REGION_COUNT 3
+
+namespace FlameUI {
+    /// GL_ARRAY_BUFFER which streams the instances of a batch to the GPU without the CPU waiting for the GPU to finish reading the previous frames.
+    /// On OpenGL 4.4 and above, the buffer is persistently and coherently mapped and split into `INSTANCE_RING_REGION_COUNT` regions,
+    /// each one guarded by a fence which is only waited on when the ring wraps around to it.
+    /// Older contexts, like the OpenGL 4.1 one of the Sandbox, orphan the buffer with `glBufferData(nullptr)` before every upload instead
+    class InstanceRingBuffer
+    {
+    public:
+        InstanceRingBuffer(uint32_t instanceSize, uint32_t regionCapacity);
+        ~InstanceRingBuffer();
+
+        /// Copies the instances into the buffer and returns the index of the first one, which is the base instance that they have to be drawn with.
+        /// `instanceCount` can't be larger than the capacity of a region
+        uint32_t Upload(const void* instances, uint32_t instanceCount);
+        /// Fences the instances uploaded during the frame and moves on to the next region
+        void     OnFrameEnd();
+        /// Recreates the buffer with room for `regionCapacity` instances per frame, the vertex attributes have to be pointed at the new buffer afterwards
+        void     Resize(uint32_t regionCapacity);
+        uint32_t GetBufferId() const { return m_BufferId; }
+        bool     IsPersistentlyMapped() const { return m_MappedData != nullptr; }
+    private:
+        void CreateBuffer();
+        void DestroyBuffer();
+        /// Fences the current region and waits until the GPU is done with the next one, which normally happened long before
+        void AdvanceRegion();
+    private:
+        uint32_t                                          m_BufferId;
+        uint32_t                                          m_InstanceSize, m_RegionCapacity;
+        /// Start of the mapped buffer, nullptr when the buffer is orphaned instead
+        uint8_t*                                          m_MappedData;
+        uint32_t                                          m_RegionIndex, m_RegionInstanceCount;
+        std::array<GLsync, INSTANCE_RING_REGION_COUNT>    m_RegionFences;
+    };
+}
@@ -0,0 +1,81 @@
+#include "QuadKernels.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FL_QUAD_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace FlameUI {
+    // The SSE2 kernel writes each instance as three 16 byte stores, so the layout of the instance must not change behind its back
+    static_assert(sizeof(QuadInstance) == 48, "GenerateQuadInstances() assumes a 48 byte QuadInstance");
+    static_assert(offsetof(QuadInstance, clip_rect) == 32, "GenerateQuadInstances() assumes the clip rectangle is followed by the texture layer and UV scale");
+
+#ifdef FL_QUAD_KERNELS_SSE2
+    void GenerateQuadInstances(const QuadSpans& quads, size_t first, size_t count, const glm::vec2& unitScale, const std::array<int16_t, 4>& clipRect, QuadInstance* instances)
+    {
+        // The last 16 bytes are the same for all the quads: the clip rectangle, followed by zeros for the texture layer, UV scale and shape parameter of untextured quads
+        const __m128i clipRectAndTexture = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(clipRect.data()));
+        const __m128 scale = _mm_setr_ps(unitScale.x, unitScale.y, unitScale.x, unitScale.y);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), colorMax = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+        const int32_t untexturedIndexBits = 0xBF800000; // Bits of -1.0f
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec3& position = quads.positions[first + i];
+            const glm::vec2& dimensions = quads.dimensions[first + i];
+
+            // Convert the position and the dimensions with a single multiply: { x, y, width, height }
+            __m128 scaled = _mm_mul_ps(_mm_setr_ps(position.x, position.y, dimensions.x, dimensions.y), scale);
+
+            // Pack the color the same way as `Renderer::PackColor()`: clamp, scale to 0..255, round and narrow to bytes
+            __m128 color = _mm_loadu_ps(&quads.colors[first + i].x);
+            color = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color, zero), one), colorMax), half);
+            __m128i colorBytes = _mm_cvttps_epi32(color);
+            colorBytes = _mm_packs_epi32(colorBytes, colorBytes);
+            colorBytes = _mm_packus_epi16(colorBytes, colorBytes);
+
+            int32_t elementTypeIndex = quads.elementTypeIndices ? quads.elementTypeIndices[first + i] : (uint8_t)FL_ELEMENT_TYPE_GENERAL_INDEX;
+
+            // First half: { x, y, z, width }, second half: { height, color, texture_index, element_type_index | is_panel_active | style_index }
+            __m128 positionZ = _mm_shuffle_ps(_mm_set_ss(position.z), scaled, _MM_SHUFFLE(3, 2, 0, 0));
+            __m128 low = _mm_shuffle_ps(scaled, positionZ, _MM_SHUFFLE(2, 0, 1, 0));
+            __m128 high = _mm_castsi128_ps(_mm_setr_epi32(0, _mm_cvtsi128_si32(colorBytes), untexturedIndexBits, elementTypeIndex));
+            high = _mm_move_ss(high, _mm_shuffle_ps(scaled, scaled, _MM_SHUFFLE(3, 3, 3, 3)));
+
+            float* instance = reinterpret_cast<float*>(instances + i);
+            _mm_storeu_ps(instance, low);
+            _mm_storeu_ps(instance + 4, high);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(instance + 8), clipRectAndTexture);
+        }
+    }
+#else
+    void GenerateQuadInstances(const QuadSpans& quads, size_t first, size_t count, const glm::vec2& unitScale, const std::array<int16_t, 4>& clipRect, QuadInstance* instances)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec3& position = quads.positions[first + i];
+            const glm::vec4& color = quads.colors[first + i];
+
+            QuadInstance& instance = instances[i];
+            instance.position = { position.x * unitScale.x, position.y * unitScale.y, position.z };
+            instance.dimensions = quads.dimensions[first + i] * unitScale;
+
+            uint32_t r = (uint32_t)(std::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint32_t g = (uint32_t)(std::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint32_t b = (uint32_t)(std::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+            uint32_t a = (uint32_t)(std::clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+            instance.color = r | (g << 8) | (b << 16) | (a << 24);
+
+            instance.texture_index = -1.0f;
+            instance.element_type_index = quads.elementTypeIndices ? quads.elementTypeIndices[first + i] : (uint8_t)FL_ELEMENT_TYPE_GENERAL_INDEX;
+            instance.is_panel_active = 0;
+            instance.style_index = FL_STYLE_NONE_INDEX;
+            std::copy(clipRect.begin(), clipRect.end(), instance.clip_rect);
+            instance.texture_layer = 0;
+            instance.texture_uv_scale[0] = instance.texture_uv_scale[1] = 0;
+            instance.shape_param = 0;
+        }
+    }
+#endif
+}
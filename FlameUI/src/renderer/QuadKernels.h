@@ -0,0 +1,12 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "renderer/Renderer.h"
+
+namespace FlameUI {
+    /// Fills `count` quad instances starting at `instances` from the quads `first` to `first + count` of `quads`.
+    /// Positions and dimensions are multiplied by `unitScale`, which converts them to pixels, the quads are untextured and clipped to `clipRect`.
+    /// Uses SSE2 where it is available and a scalar loop otherwise, both produce the same instances as `Renderer::AddQuad()`
+    void GenerateQuadInstances(const QuadSpans& quads, size_t first, size_t count, const glm::vec2& unitScale, const std::array<int16_t, 4>& clipRect, QuadInstance* instances);
+}
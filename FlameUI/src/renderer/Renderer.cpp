@@ -2,9 +2,21 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "utils/Timer.h"
+#include "utils/Hash.h"
+#include "utils/MappedFile.h"
+#include "utils/RadixSort.h"
+#include "renderer/QuadKernels.h"
+#include "renderer/GLState.h"
+#include "renderer/SortKey.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
@@ -13,31 +25,75 @@
 #include "msdfgen/msdfgen-ext.h"
 
 namespace FlameUI {
-    std::unordered_map<std::string, GLint>     Renderer::s_UniformLocationCache;
-    std::unordered_map<std::string, uint32_t>  Renderer::s_TextureIdCache;
-    std::unordered_map<char, flame::character> Renderer::s_Characters;
+    /// Draws the instanced quads of the bound vertex array, instances uploaded to a persistently mapped ring don't start at 0.
+    /// A non zero base instance needs OpenGL 4.2, which every context that supports the persistent mapping has
+    static void DrawInstancedQuads(uint32_t firstInstance, uint32_t instanceCount)
+    {
+        if (firstInstance)
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, (GLsizei)instanceCount, firstInstance);
+        else
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)instanceCount);
+    }
+
+    // Names of the uniforms looked up every frame, hashed at compile time
+    static constexpr HashedId s_TextureSamplersUniform = "u_TextureSamplers";
+    static constexpr HashedId s_FontAtlasUniform = "u_FontAtlas";
+    static constexpr HashedId s_PixelRangeUniform = "u_PixelRange";
+    static constexpr HashedId s_StrengthUniform = "u_Strength";
+    static constexpr HashedId s_AlphaPassUniform = "u_AlphaPass";
+
+    std::unordered_map<uint32_t, Renderer::UniformLocationTable> Renderer::s_UniformLocationTables;
+    std::shared_ptr<TextureArrayPool>          Renderer::s_TextureArrayPool;
+    std::shared_ptr<TextureCache>              Renderer::s_TextureCache;
+    uint32_t                                   Renderer::s_TextureSlotCount = MAX_TEXTURE_SLOTS;
+    std::vector<Rect2D>                        Renderer::s_ClipRects;
+    std::array<int16_t, 4>                     Renderer::s_PackedClipRect = { -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT, -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT };
+    uint32_t                                   Renderer::s_RejectedQuadCount = 0;
+    uint32_t                                   Renderer::s_QuadDrawCallCount = 0;
+    std::unordered_map<uint32_t, flame::character> Renderer::s_Characters;
+    std::array<const flame::character*, 128>   Renderer::s_AsciiCharacters{};
+    std::unordered_set<uint32_t>               Renderer::s_MissingCodepoints;
+    uint64_t                                   Renderer::s_FrameIndex = 0;
     Renderer::Batch                            Renderer::s_Batch;
+    Renderer::RetainedBatch                    Renderer::s_RetainedBatch;
+    Renderer::PartialRedraw                    Renderer::s_PartialRedraw;
+    Renderer::TextBatch                        Renderer::s_TextBatch;
+    std::shared_ptr<GlyphAtlas>                Renderer::s_GlyphAtlas;
+    msdfgen::FreetypeHandle*                   Renderer::s_FreetypeHandle = nullptr;
+    msdfgen::FontHandle*                       Renderer::s_FontHandle = nullptr;
+    std::shared_ptr<ThreadPool>                Renderer::s_WorkerPool;
+    std::shared_ptr<TextLayoutCache>           Renderer::s_TextLayoutCache;
     uint32_t                                   Renderer::s_UniformBufferId;
     glm::vec2                                  Renderer::s_WindowContentScale;
     float                                      Renderer::s_AspectRatio = (float)(1280.0f / 720.0f);
     std::string                                Renderer::s_UserFontFilePath = "";
+    std::string                                Renderer::s_FontCacheDirectory = "";
     Renderer::UniformBufferData                Renderer::s_UniformBufferData;
     ThemeInfo                                  Renderer::s_ThemeInfo{};
-    Renderer::FontProps                        Renderer::s_FontProps = { .Scale = 1.0f, .Strength = 0.5f, .PixelRange = 8.0f };
+    uint32_t                                   Renderer::s_ThemeUniformBufferId;
+    bool                                       Renderer::s_IsThemeDirty = true;
+    uint32_t                                   Renderer::s_ThemeRevision = 0;
+    Renderer::FontProps                        Renderer::s_FontProps = { .Scale = 1.0f, .Strength = 0.5f, .PixelRange = 8.0f, .BorderWidth = 2.0f };
     glm::vec2                                  Renderer::s_ViewportSize = { 1280.0f, 720.0f };
     glm::vec2                                  Renderer::s_CursorPosition = { 0.0f, 0.0f };
-    float                                      Renderer::s_CurrentTextureSlot = 0;
     GLFWwindow* Renderer::s_UserWindow;
 
     void Renderer::OnResize()
     {
         int width, height;
         glfwGetFramebufferSize(s_UserWindow, &width, &height);
-        s_ViewportSize = { width, height };
+        glm::vec2 viewportSize = { width, height };
+        if (viewportSize != s_ViewportSize)
+            InvalidateViewportDependentState();
+
+        s_ViewportSize = viewportSize;
         s_AspectRatio = s_ViewportSize.x / s_ViewportSize.y;
-        s_UniformBufferData.ProjectionMatrix = glm::ortho(-s_AspectRatio, s_AspectRatio, -1.0f, 1.0f, -1.0f, 1.0f);
 
-        glViewport(0, 0, s_ViewportSize.x, s_ViewportSize.y);
+        // Geometry is submitted in pixels relative to the center of the viewport, so that it stays valid across resizes and content scale changes
+        glm::vec2 halfViewportInPixels = s_ViewportSize / s_WindowContentScale / 2.0f;
+        s_UniformBufferData.ProjectionMatrix = glm::ortho(-halfViewportInPixels.x, halfViewportInPixels.x, -halfViewportInPixels.y, halfViewportInPixels.y, -1.0f, 1.0f);
+
+        GLState::Viewport(0, 0, s_ViewportSize.x, s_ViewportSize.y);
     }
 
     glm::vec2  Renderer::GetViewportSize() { return s_ViewportSize; }
@@ -46,10 +102,14 @@ namespace FlameUI {
 
     void Renderer::OnUpdate()
     {
-        glClear(GL_DEPTH_BUFFER_BIT);
+        // In partial redraw mode everything is drawn into the back buffer, which clears its own depth in `PrepareFrameForDrawing()`
+        if (!s_PartialRedraw.IsEnabled)
+            glClear(GL_DEPTH_BUFFER_BIT);
 
         glm::vec2 scale;
         glfwGetWindowContentScale(s_UserWindow, &scale.x, &scale.y);
+        if (scale != s_WindowContentScale)
+            InvalidateViewportDependentState();
         s_WindowContentScale = scale;
 
         double x, y;
@@ -67,6 +127,7 @@ namespace FlameUI {
         s_UserWindow = rendererInitInfo.userWindow;
         if (rendererInitInfo.themeInfo)
             s_ThemeInfo = *rendererInitInfo.themeInfo;
+        s_ThemeRevision++;
 
         GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
         const char* monitorName = glfwGetMonitorName(primaryMonitor);
@@ -80,78 +141,183 @@ namespace FlameUI {
         glfwGetFramebufferSize(s_UserWindow, &width, &height);
         s_ViewportSize = { (float)width, (float)height };
 
+        s_WorkerPool = std::make_shared<ThreadPool>();
+
+        s_PartialRedraw.IsEnabled = rendererInitInfo.enablePartialRedraw;
+        s_PartialRedraw.FullRedrawThreshold = rendererInitInfo.fullRedrawDamageThreshold;
+        if (s_PartialRedraw.IsEnabled)
+            s_PartialRedraw.BackBuffer = std::make_shared<Framebuffer>(s_ViewportSize.x, s_ViewportSize.y);
+
         if (rendererInitInfo.enableFontRendering)
         {
             s_UserFontFilePath = rendererInitInfo.fontFilePath;
+            s_FontCacheDirectory = rendererInitInfo.fontCacheDirectory;
             LoadFont(s_UserFontFilePath);
+            s_TextLayoutCache = std::make_shared<TextLayoutCache>(GetCharacter, s_FontProps.ContentHash, s_FontProps.AscenderY, s_FontProps.DescenderY);
             FL_INFO("Loaded Font from path \"{0}\"", s_UserFontFilePath);
         }
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_DEPTH_TEST);
+        GLState::SetCapability(GL_BLEND, true);
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::SetCapability(GL_DEPTH_TEST, true);
 
         /* Create Uniform Buffer */
         glGenBuffers(1, &s_UniformBufferId);
-        glBindBuffer(GL_UNIFORM_BUFFER, s_UniformBufferId);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, s_UniformBufferId);
         glBufferData(GL_UNIFORM_BUFFER, sizeof(UniformBufferData), nullptr, GL_DYNAMIC_DRAW);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 0, s_UniformBufferId, 0, sizeof(UniformBufferData));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        GLState::BindBufferRange(GL_UNIFORM_BUFFER, 0, s_UniformBufferId, 0, sizeof(UniformBufferData));
+
+        /* Create Theme Uniform Buffer */
+        glGenBuffers(1, &s_ThemeUniformBufferId);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, s_ThemeUniformBufferId);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ThemeUniformBufferData), nullptr, GL_DYNAMIC_DRAW);
+        GLState::BindBufferRange(GL_UNIFORM_BUFFER, 1, s_ThemeUniformBufferId, 0, sizeof(ThemeUniformBufferData));
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, 0);
+        s_IsThemeDirty = true;
 
         InitBatch();
+        s_TextureCache = std::make_shared<TextureCache>(s_WorkerPool, s_TextureArrayPool, rendererInitInfo.textureMemoryBudget);
+        s_Batch.ShaderStrategy = rendererInitInfo.quadShaderStrategy;
+        InitRetainedBatch();
+        if (rendererInitInfo.enableFontRendering)
+            InitTextBatch();
         FL_INFO("Initialized Renderer!");
     }
 
     void Renderer::InitBatch()
     {
-        s_Batch.TextureIds.reserve(MAX_TEXTURE_SLOTS);
+        // The shader has MAX_TEXTURE_SLOTS samplers, GPUs with fewer texture image units in the fragment shader only use as many of them as they have
+        GLint maxTextureImageUnits = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureImageUnits);
+        s_TextureSlotCount = std::min((uint32_t)std::max(maxTextureImageUnits, 1), (uint32_t)MAX_TEXTURE_SLOTS);
+        s_Batch.TextureIds.reserve(s_TextureSlotCount);
+        s_TextureArrayPool = std::make_shared<TextureArrayPool>();
 
-        uint32_t indices[MAX_INDICES];
-        size_t offset = 0;
-        for (size_t i = 0; i < MAX_INDICES; i += 6)
-        {
-            indices[0 + i] = 1 + offset;
-            indices[1 + i] = 2 + offset;
-            indices[2 + i] = 3 + offset;
+        glGenVertexArrays(1, &s_Batch.VertexArrayId);
+        ResizeBatch(INITIAL_BATCH_QUADS);
+        FL_INFO("Streaming batch instances using {0}", s_Batch.InstanceRing->IsPersistentlyMapped() ? "a persistently mapped ring buffer" : "buffer orphaning");
 
-            indices[3 + i] = 3 + offset;
-            indices[4 + i] = 0 + offset;
-            indices[5 + i] = 1 + offset;
+        std::string quadShaderPath = FL_PROJECT_DIR + std::string("FlameUI/resources/shaders/Quad.glsl");
+        s_Batch.ShaderProgramId = CreateShaderProgram(quadShaderPath);
+        SetupQuadShaderProgram(s_Batch.ShaderProgramId);
 
-            offset += 4;
+        // Every variant is compiled up front, so that switching the strategy never stalls a frame on shader compilation
+        for (uint32_t elementType = 0; elementType < FL_ELEMENT_TYPE_COUNT; elementType++)
+        {
+            s_Batch.VariantShaderProgramIds[elementType] = CreateShaderProgram(quadShaderPath, "#define FL_ELEMENT_TYPE_VARIANT " + std::to_string(elementType) + "\n");
+            SetupQuadShaderProgram(s_Batch.VariantShaderProgramIds[elementType]);
         }
+        GLState::UseProgram(0);
+    }
 
-        glGenVertexArrays(1, &s_Batch.VertexArrayId);
-        glBindVertexArray(s_Batch.VertexArrayId);
-
-        glGenBuffers(1, &s_Batch.VertexBufferId);
-        glBindBuffer(GL_ARRAY_BUFFER, s_Batch.VertexBufferId);
-        glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+    void Renderer::SetupQuadShaderProgram(uint32_t programId)
+    {
+        GLState::UseProgram(programId);
 
-        glBindVertexArray(s_Batch.VertexArrayId);
+        // The samplers past the texture slots of the GPU are never sampled, they only need to point at a valid texture unit
+        int samplers[MAX_TEXTURE_SLOTS];
+        for (uint32_t i = 0; i < MAX_TEXTURE_SLOTS; i++)
+            samplers[i] = std::min(i, s_TextureSlotCount - 1);
+        glUniform1iv(Renderer::GetUniformLocation(s_TextureSamplersUniform, programId), MAX_TEXTURE_SLOTS, samplers);
+        // GLSL 4.10 has no layout(binding) qualifier for uniform blocks, so the Theme block is bound to its binding point here
+        glUniformBlockBinding(programId, glGetUniformBlockIndex(programId, "Theme"), 1);
+    }
 
+    void Renderer::SetupQuadInstanceAttributes(uint32_t firstInstance)
+    {
+        // Every attribute advances once per instance, the corners of the quad are generated by the vertex shader using gl_VertexID
+        size_t offset = (size_t)firstInstance * sizeof(QuadInstance);
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, position));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, position)));
+        glVertexAttribDivisor(0, 1);
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, color));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, dimensions)));
+        glVertexAttribDivisor(1, 1);
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, texture_uv));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, color)));
+        glVertexAttribDivisor(2, 1);
         glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, texture_index));
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, texture_index)));
+        glVertexAttribDivisor(3, 1);
         glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, quad_dimensions));
+        glVertexAttribPointer(4, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, element_type_index)));
+        glVertexAttribDivisor(4, 1);
         glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, element_type_index));
+        glVertexAttribPointer(5, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, is_panel_active)));
+        glVertexAttribDivisor(5, 1);
         glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)offsetof(Vertex, is_panel_active));
+        glVertexAttribPointer(6, 1, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, style_index)));
+        glVertexAttribDivisor(6, 1);
+        glEnableVertexAttribArray(7);
+        glVertexAttribPointer(7, 4, GL_SHORT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, clip_rect)));
+        glVertexAttribDivisor(7, 1);
+        glEnableVertexAttribArray(8);
+        glVertexAttribPointer(8, 1, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, texture_layer)));
+        glVertexAttribDivisor(8, 1);
+        glEnableVertexAttribArray(9);
+        glVertexAttribPointer(9, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, texture_uv_scale)));
+        glVertexAttribDivisor(9, 1);
+        glEnableVertexAttribArray(10);
+        glVertexAttribPointer(10, 1, GL_SHORT, GL_FALSE, sizeof(QuadInstance), (void*)(offset + offsetof(QuadInstance, shape_param)));
+        glVertexAttribDivisor(10, 1);
+    }
+
+    void Renderer::InitRetainedBatch()
+    {
+        glGenVertexArrays(1, &s_RetainedBatch.VertexArrayId);
+        GLState::BindVertexArray(s_RetainedBatch.VertexArrayId);
+
+        glGenBuffers(1, &s_RetainedBatch.InstanceBufferId);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, s_RetainedBatch.InstanceBufferId);
+        SetupQuadInstanceAttributes();
+    }
+
+    void Renderer::InitTextBatch()
+    {
+        s_TextBatch.Instances.reserve(MAX_TEXT_BATCH_GLYPHS);
+
+        glGenVertexArrays(1, &s_TextBatch.VertexArrayId);
+        GLState::BindVertexArray(s_TextBatch.VertexArrayId);
 
-        glGenBuffers(1, &s_Batch.IndexBufferId);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Batch.IndexBufferId);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        s_TextBatch.InstanceRing = std::make_shared<InstanceRingBuffer>((uint32_t)sizeof(GlyphInstance), MAX_TEXT_BATCH_GLYPHS);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, s_TextBatch.InstanceRing->GetBufferId());
 
-        glBindVertexArray(s_Batch.VertexArrayId);
+        // Every attribute advances once per glyph, the corners of the glyph quad are generated by the vertex shader
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, position));
+        glVertexAttribDivisor(0, 1);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, dimensions));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, texture_uv_rect));
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, color));
+        glVertexAttribDivisor(3, 1);
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, atlas_page));
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_SHORT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, clip_rect));
+        glVertexAttribDivisor(5, 1);
+
+        s_TextBatch.ShaderProgramId = CreateShaderProgram(FL_PROJECT_DIR + std::string("FlameUI/resources/shaders/Font.glsl"));
+
+        GLState::UseProgram(s_TextBatch.ShaderProgramId);
+        glUniform1i(Renderer::GetUniformLocation(s_FontAtlasUniform, s_TextBatch.ShaderProgramId), 0);
+        GLState::UseProgram(0);
+    }
 
-        auto [vertexSource, fragmentSource] = Renderer::ReadShaderSource(FL_PROJECT_DIR + std::string("FlameUI/resources/shaders/Quad.glsl"));
+    uint32_t Renderer::CreateShaderProgram(const std::string& filePath, const std::string& defines)
+    {
+        auto [vertexSource, fragmentSource] = Renderer::ReadShaderSource(filePath);
+        // #version has to stay the first statement of both stages, so the defines go right after it
+        for (std::string* source : { &vertexSource, &fragmentSource })
+        {
+            size_t versionLineEnd = source->find('\n', source->find("#version"));
+            source->insert(versionLineEnd == std::string::npos ? source->size() : versionLineEnd + 1, defines);
+        }
         // Create an empty vertex shader handle
         GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
 
@@ -212,29 +378,29 @@ namespace FlameUI {
         // Vertex and fragment shaders are successfully compiled.
         // Now time to link them together into a program.
         // Get a program object.
-        s_Batch.ShaderProgramId = glCreateProgram();
+        uint32_t shaderProgramId = glCreateProgram();
 
         // Attach our shaders to our program
-        glAttachShader(s_Batch.ShaderProgramId, vertex_shader);
-        glAttachShader(s_Batch.ShaderProgramId, fragment_shader);
+        glAttachShader(shaderProgramId, vertex_shader);
+        glAttachShader(shaderProgramId, fragment_shader);
 
         // Link our program
-        glLinkProgram(s_Batch.ShaderProgramId);
+        glLinkProgram(shaderProgramId);
 
         // Note the different functions here: glGetProgram* instead of glGetShader*.
         GLint isLinked = 0;
-        glGetProgramiv(s_Batch.ShaderProgramId, GL_LINK_STATUS, (int*)&isLinked);
+        glGetProgramiv(shaderProgramId, GL_LINK_STATUS, (int*)&isLinked);
         if (isLinked == GL_FALSE)
         {
             GLint maxLength = 0;
-            glGetProgramiv(s_Batch.ShaderProgramId, GL_INFO_LOG_LENGTH, &maxLength);
+            glGetProgramiv(shaderProgramId, GL_INFO_LOG_LENGTH, &maxLength);
 
             // The maxLength includes the NULL character
             std::vector<GLchar> infoLog(maxLength);
-            glGetProgramInfoLog(s_Batch.ShaderProgramId, maxLength, &maxLength, &infoLog[0]);
+            glGetProgramInfoLog(shaderProgramId, maxLength, &maxLength, &infoLog[0]);
 
             // We don't need the program anymore.
-            glDeleteProgram(s_Batch.ShaderProgramId);
+            glDeleteProgram(shaderProgramId);
             // Don't leak shaders either.
             glDeleteShader(vertex_shader);
             glDeleteShader(fragment_shader);
@@ -243,298 +409,1209 @@ namespace FlameUI {
         }
 
         // Always detach shaders after a successful link.
-        glDetachShader(s_Batch.ShaderProgramId, vertex_shader);
-        glDetachShader(s_Batch.ShaderProgramId, fragment_shader);
+        glDetachShader(shaderProgramId, vertex_shader);
+        glDetachShader(shaderProgramId, fragment_shader);
 
-        glUseProgram(s_Batch.ShaderProgramId);
+        // Ids of deleted programs are handed out again, so a program never finds the uniform locations of an older one
+        s_UniformLocationTables[shaderProgramId] = UniformLocationTable{};
 
-        int samplers[MAX_TEXTURE_SLOTS];
-        for (uint32_t i = 0; i < MAX_TEXTURE_SLOTS; i++)
-            samplers[i] = i;
-        glUniform1iv(Renderer::GetUniformLocation("u_TextureSamplers", s_Batch.ShaderProgramId), MAX_TEXTURE_SLOTS, samplers);
-        glUseProgram(0);
+        return shaderProgramId;
+    }
+
+    void Renderer::ResizeBatch(uint32_t quadCapacity)
+    {
+        if (!s_Batch.InstanceRing)
+            s_Batch.InstanceRing = std::make_shared<InstanceRingBuffer>((uint32_t)sizeof(QuadInstance), quadCapacity);
+        else
+            s_Batch.InstanceRing->Resize(quadCapacity);
+
+        // The ring is a new buffer after every resize, so the attributes of the vertex array are pointed at it again
+        GLState::BindVertexArray(s_Batch.VertexArrayId);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, s_Batch.InstanceRing->GetBufferId());
+        SetupQuadInstanceAttributes();
+
+        // Reserve the CPU side storage up front, so that filling the batch never reallocates during a frame
+        s_Batch.Instances.reserve(quadCapacity);
+        s_Batch.SortKeys.reserve(quadCapacity);
+        s_Batch.SortedOrder.reserve(quadCapacity);
+        s_Batch.SortScratch.reserve(quadCapacity);
+        s_Batch.SortedInstances.reserve(quadCapacity);
+        s_Batch.QuadCapacity = quadCapacity;
+    }
+
+    void Renderer::PrepareBatchForQuad()
+    {
+        // Retained quads are uploaded when the range ends, they never take space in the batch
+        if (s_RetainedBatch.RecordingRangeId != FL_INVALID_RETAINED_RANGE)
+            return;
+
+        // Flush mid-frame when the batch is full, instead of uploading past the end of the instance buffer
+        if (s_Batch.Instances.size() + 1 > (size_t)s_Batch.QuadCapacity)
+            FlushBatch();
+        s_Batch.FrameQuadCount++;
     }
 
     void Renderer::FlushBatch()
     {
-        if (!s_Batch.Vertices.size())
+        if (!s_Batch.Instances.size())
             return;
 
-        glBindBuffer(GL_ARRAY_BUFFER, s_Batch.VertexBufferId);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, s_Batch.Vertices.size() * sizeof(Vertex), s_Batch.Vertices.data());
+        // A translucent quad drawn with depth writes before the panels behind it would hide them, so they are drawn first even when the batch overflows mid-frame
+        if (!s_RetainedBatch.IsOpaquePassDrawn)
+            DrawRetainedBatch(QuadAlphaPass::OPAQUE_FRAGMENTS);
+
+        PrepareFrameForDrawing(false);
+        if (s_PartialRedraw.IsFrameDrawSkipped)
+        {
+            s_Batch.Instances.clear();
+            s_Batch.TextureIds.clear();
+            return;
+        }
+
+        const QuadInstance* instances = SortBatchInstances();
+        uint32_t firstInstance = s_Batch.InstanceRing->Upload(instances, (uint32_t)s_Batch.Instances.size());
 
         for (uint8_t i = 0; i < s_Batch.TextureIds.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(GL_TEXTURE_2D, s_Batch.TextureIds[i]);
-        }
-
-        glUseProgram(s_Batch.ShaderProgramId);
-        glUniform1f(Renderer::GetUniformLocation("u_TitleBarHeight", s_Batch.ShaderProgramId), Renderer::ConvertYAxisPixelValueToOpenGLValue(TITLE_BAR_HEIGHT));
-
-        glUniform4f(
-            Renderer::GetUniformLocation("u_PanelTitleBarActiveColor", s_Batch.ShaderProgramId),
-            s_ThemeInfo.panelTitleBarActiveColor.x,
-            s_ThemeInfo.panelTitleBarActiveColor.y,
-            s_ThemeInfo.panelTitleBarActiveColor.z,
-            s_ThemeInfo.panelTitleBarActiveColor.w
-        );
-        glUniform4f(
-            Renderer::GetUniformLocation("u_PanelTitleBarInactiveColor", s_Batch.ShaderProgramId),
-            s_ThemeInfo.panelTitleBarInactiveColor.x,
-            s_ThemeInfo.panelTitleBarInactiveColor.y,
-            s_ThemeInfo.panelTitleBarInactiveColor.z,
-            s_ThemeInfo.panelTitleBarInactiveColor.w
-        );
-        glUniform4f(
-            Renderer::GetUniformLocation("u_PanelBgColor", s_Batch.ShaderProgramId),
-            s_ThemeInfo.panelBgColor.x,
-            s_ThemeInfo.panelBgColor.y,
-            s_ThemeInfo.panelBgColor.z,
-            s_ThemeInfo.panelBgColor.w
-        );
-        glUniform4f(
-            Renderer::GetUniformLocation("u_BorderColor", s_Batch.ShaderProgramId),
-            s_ThemeInfo.borderColor.x,
-            s_ThemeInfo.borderColor.y,
-            s_ThemeInfo.borderColor.z,
-            s_ThemeInfo.borderColor.w
-        );
-
-        glBindVertexArray(s_Batch.VertexArrayId);
-        glDrawElements(GL_TRIANGLES, (s_Batch.Vertices.size() / 4) * 6, GL_UNSIGNED_INT, 0);
-
-        s_Batch.Vertices.clear();
+            GLState::BindTexture(i, GL_TEXTURE_2D_ARRAY, s_Batch.TextureIds[i]);
+        }
+
+        // The theme colors come from the Theme uniform buffer, which is only uploaded when the theme changes
+        GLState::BindVertexArray(s_Batch.VertexArrayId);
+        DrawQuadInstances(instances, firstInstance, (uint32_t)s_Batch.Instances.size(), s_Batch.InstanceRing->GetBufferId());
+
+        s_Batch.Instances.clear();
         s_Batch.TextureIds.clear();
     }
 
-    void Renderer::AddQuad(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, UnitType unitType, bool isPanelActive)
+    const QuadInstance* Renderer::SortBatchInstances()
     {
-        Vertex vertices[4];
+        auto& instances = s_Batch.Instances;
+        uint32_t instanceCount = (uint32_t)instances.size();
 
-        vertices[0].texture_uv = { 0.0f, 0.0f };
-        vertices[1].texture_uv = { 0.0f, 1.0f };
-        vertices[2].texture_uv = { 1.0f, 1.0f };
-        vertices[3].texture_uv = { 1.0f, 0.0f };
+        bool isSorted = true;
+        s_Batch.SortKeys.resize(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            // Untextured quads have a texture index of -1.0f, so the texture slots are shifted up by one
+            s_Batch.SortKeys[i] = MakeSortKey(instances[i].position.z, instances[i].element_type_index, (uint16_t)(instances[i].texture_index + 1.0f));
+            isSorted &= !i || s_Batch.SortKeys[i - 1] <= s_Batch.SortKeys[i];
+        }
+
+        // Quads submitted back to front with their materials grouped, which is the usual case, are uploaded as they are
+        if (isSorted)
+            return instances.data();
+
+        RadixSortIndices(s_Batch.SortKeys.data(), instanceCount, s_Batch.SortedOrder, s_Batch.SortScratch);
+        s_Batch.SortedInstances.resize(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; i++)
+            s_Batch.SortedInstances[i] = instances[s_Batch.SortedOrder[i]];
+        return s_Batch.SortedInstances.data();
+    }
+
+    void Renderer::FlushTextBatch()
+    {
+        if (!s_TextBatch.Instances.size())
+            return;
+
+        // Text flushed mid-frame writes depth too, so the panels behind it are drawn first just like for `FlushBatch()`
+        if (!s_RetainedBatch.IsOpaquePassDrawn)
+            DrawRetainedBatch(QuadAlphaPass::OPAQUE_FRAGMENTS);
+
+        PrepareFrameForDrawing(false);
+        if (s_PartialRedraw.IsFrameDrawSkipped)
+        {
+            s_TextBatch.Instances.clear();
+            return;
+        }
 
-        glm::mat4 transformation{ 1.0f };
+        uint32_t firstInstance = s_TextBatch.InstanceRing->Upload(s_TextBatch.Instances.data(), (uint32_t)s_TextBatch.Instances.size());
+
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, s_GlyphAtlas->GetTextureId());
+
+        GLState::UseProgram(s_TextBatch.ShaderProgramId);
+        glUniform1f(Renderer::GetUniformLocation(s_PixelRangeUniform, s_TextBatch.ShaderProgramId), s_FontProps.PixelRange);
+        glUniform1f(Renderer::GetUniformLocation(s_StrengthUniform, s_TextBatch.ShaderProgramId), s_FontProps.Strength);
+
+        GLState::BindVertexArray(s_TextBatch.VertexArrayId);
+        DrawInstancedQuads(firstInstance, (uint32_t)s_TextBatch.Instances.size());
+
+        s_TextBatch.Instances.clear();
+    }
+
+    uint32_t Renderer::PackColor(const glm::vec4& color)
+    {
+        uint32_t r = (uint32_t)(std::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(std::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(std::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+        uint32_t a = (uint32_t)(std::clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+        // Stored as bytes r, g, b, a in memory, which is the order the GL_UNSIGNED_BYTE vertex attribute reads them in
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    void Renderer::AddQuadInstance(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, float textureIndex, UnitType unitType, bool isPanelActive, uint16_t styleIndex, const TextureLocation* texture, int16_t shapeParam)
+    {
+        QuadInstance instance;
 
         switch (unitType)
         {
             case UnitType::PIXEL_UNITS:
-                transformation = glm::translate(glm::mat4(1.0f), { ConvertPixelsToOpenGLValues({ position.x, position.y }), position.z });
-                transformation = glm::scale(transformation, { ConvertPixelsToOpenGLValues(dimensions), 0.0f });
+                instance.position = position;
+                instance.dimensions = dimensions;
                 break;
             case UnitType::OPENGL_UNITS:
-                transformation = glm::translate(glm::mat4(1.0f), position);
-                transformation = glm::scale(transformation, { dimensions, 0.0f });
+            {
+                glm::vec2 openGLUnitsPerPixel = ConvertPixelsToOpenGLValues(glm::vec2(1.0f));
+                instance.position = { glm::vec2(position.x, position.y) / openGLUnitsPerPixel, position.z };
+                instance.dimensions = dimensions / openGLUnitsPerPixel;
                 break;
+            }
             default:
                 break;
         }
 
-        for (uint8_t i = 0; i < 4; i++)
+        instance.color = PackColor(color);
+        instance.texture_index = textureIndex;
+        instance.element_type_index = (uint8_t)elementTypeIndex;
+        instance.is_panel_active = isPanelActive ? 1 : 0;
+        instance.style_index = styleIndex;
+        std::copy(s_PackedClipRect.begin(), s_PackedClipRect.end(), instance.clip_rect);
+        if (texture)
+        {
+            instance.texture_layer = texture->Layer;
+            instance.texture_uv_scale[0] = (uint16_t)(std::clamp(texture->UVScale.x, 0.0f, 1.0f) * 65535.0f + 0.5f);
+            instance.texture_uv_scale[1] = (uint16_t)(std::clamp(texture->UVScale.y, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+        instance.shape_param = shapeParam;
+
+        if (s_RetainedBatch.RecordingRangeId != FL_INVALID_RETAINED_RANGE)
+            s_RetainedBatch.RecordedInstances.push_back(instance);
+        else
+            s_Batch.Instances.push_back(instance);
+    }
+
+    void Renderer::AddQuad(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, UnitType unitType, bool isPanelActive)
+    {
+        if (!IsQuadVisible(position, dimensions, unitType))
+            return;
+        PrepareBatchForQuad();
+        AddQuadInstance(position, dimensions, color, elementTypeIndex, -1.0f, unitType, isPanelActive);
+    }
+
+    void Renderer::AddQuads(const QuadSpans& quads, UnitType unitType)
+    {
+        // OpenGL units convert to pixels by a per-axis scale, which the kernel applies to all the quads at once
+        glm::vec2 unitScale = unitType == UnitType::OPENGL_UNITS ? glm::vec2(1.0f) / ConvertPixelsToOpenGLValues(glm::vec2(1.0f)) : glm::vec2(1.0f);
+
+        if (s_RetainedBatch.RecordingRangeId != FL_INVALID_RETAINED_RANGE)
+        {
+            auto& recordedInstances = s_RetainedBatch.RecordedInstances;
+            size_t offset = recordedInstances.size();
+            recordedInstances.resize(offset + quads.count);
+            GenerateQuadInstances(quads, 0, quads.count, unitScale, s_PackedClipRect, recordedInstances.data() + offset);
+            recordedInstances.resize(offset + RemoveInvisibleInstances(recordedInstances.data() + offset, quads.count));
+            return;
+        }
+
+        // Fill the batch up to its capacity and flush, as many times as the quads need
+        size_t first = 0;
+        while (first < quads.count)
         {
-            vertices[i].position = transformation * s_TemplateVertexPositions[i];
-            vertices[i].element_type_index = elementTypeIndex;
-            vertices[i].color = color;
-            vertices[i].quad_dimensions = ConvertPixelsToOpenGLValues(dimensions);
-            vertices[i].is_panel_active = isPanelActive ? 1.0f : 0.0f;
+            if (s_Batch.Instances.size() >= (size_t)s_Batch.QuadCapacity)
+                FlushBatch();
+
+            size_t offset = s_Batch.Instances.size();
+            size_t count = std::min(quads.count - first, (size_t)s_Batch.QuadCapacity - offset);
+            s_Batch.Instances.resize(offset + count);
+            GenerateQuadInstances(quads, first, count, unitScale, s_PackedClipRect, s_Batch.Instances.data() + offset);
+            // The kernel writes all the quads, the rejected ones are removed afterwards in a single pass
+            size_t visibleCount = RemoveInvisibleInstances(s_Batch.Instances.data() + offset, count);
+            s_Batch.Instances.resize(offset + visibleCount);
+
+            s_Batch.FrameQuadCount += (uint32_t)visibleCount;
+            first += count;
         }
+    }
+
+    void Renderer::AddStyledQuad(const glm::vec3& position, const glm::vec2& dimensions, uint16_t styleIndex, const float elementTypeIndex, UnitType unitType, bool isPanelActive)
+    {
+        FL_ASSERT(styleIndex < FL_STYLE_COUNT, "Style index {0} is out of range!", styleIndex);
+        if (!IsQuadVisible(position, dimensions, unitType))
+            return;
+        PrepareBatchForQuad();
+        AddQuadInstance(position, dimensions, glm::vec4(1.0f), elementTypeIndex, -1.0f, unitType, isPanelActive, styleIndex);
+    }
+
+    void Renderer::AddShape(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, float shapeParam, bool isDescending)
+    {
+        // The quad covers the shape and a pixel around it, which the shader fades the edge of the shape into
+        glm::vec2 paddedDimensions = { dimensions.x + 2.0f * FL_SHAPE_AA_PADDING, dimensions.y + 2.0f * FL_SHAPE_AA_PADDING };
+        if (!IsQuadVisible(position, paddedDimensions, UnitType::PIXEL_UNITS))
+            return;
+
+        int16_t packedShapeParam = (int16_t)std::clamp(std::round(shapeParam * FL_SHAPE_PARAM_SCALE), 0.0f, (float)INT16_MAX);
+        PrepareBatchForQuad();
+        AddQuadInstance(position, paddedDimensions, color, elementTypeIndex, -1.0f, UnitType::PIXEL_UNITS, false, FL_STYLE_NONE_INDEX, nullptr, isDescending ? -packedShapeParam : packedShapeParam);
+    }
+
+    void Renderer::AddPanelShadow(const glm::vec3& panelPosition, const glm::vec2& panelDimensions)
+    {
+        if (s_ThemeInfo.panelShadowBlurSigma <= 0.0f || s_ThemeInfo.panelShadowColor.w <= 0.0f)
+            return;
+
+        // The gaussian is cut off at 3 sigma, where less than half a percent of the shadow is left
+        float extent = 3.0f * s_ThemeInfo.panelShadowBlurSigma;
+        glm::vec3 position = { panelPosition.x + s_ThemeInfo.panelShadowOffset.x, panelPosition.y + s_ThemeInfo.panelShadowOffset.y, panelPosition.z };
+        glm::vec2 dimensions = { panelDimensions.x + 2.0f * extent, panelDimensions.y + 2.0f * extent };
+        if (!IsQuadVisible(position, dimensions, UnitType::PIXEL_UNITS))
+            return;
+
+        PrepareBatchForQuad();
+        AddQuadInstance(position, dimensions, s_ThemeInfo.panelShadowColor, FL_ELEMENT_TYPE_PANEL_SHADOW_INDEX, -1.0f, UnitType::PIXEL_UNITS, false);
+    }
+
+    Rect2D Renderer::GetPanelShadowBounds(const Rect2D& panel_rect_in_pixels)
+    {
+        if (s_ThemeInfo.panelShadowBlurSigma <= 0.0f || s_ThemeInfo.panelShadowColor.w <= 0.0f)
+            return panel_rect_in_pixels;
+
+        float extent = 3.0f * s_ThemeInfo.panelShadowBlurSigma;
+        const glm::vec2& offset = s_ThemeInfo.panelShadowOffset;
+        return {
+            std::min(panel_rect_in_pixels.l, panel_rect_in_pixels.l + offset.x - extent),
+            std::max(panel_rect_in_pixels.r, panel_rect_in_pixels.r + offset.x + extent),
+            std::min(panel_rect_in_pixels.b, panel_rect_in_pixels.b + offset.y - extent),
+            std::max(panel_rect_in_pixels.t, panel_rect_in_pixels.t + offset.y + extent)
+        };
+    }
 
-        for (uint8_t i = 0; i < 4; i++)
-            s_Batch.Vertices.push_back(vertices[i]);
+    void Renderer::AddCircle(const glm::vec3& center, float radius, const glm::vec4& color)
+    {
+        AddShape(center, glm::vec2(2.0f * radius), color, FL_ELEMENT_TYPE_CIRCLE_INDEX, 0.0f);
+    }
+
+    void Renderer::AddRing(const glm::vec3& center, float radius, float thickness, const glm::vec4& color)
+    {
+        AddShape(center, glm::vec2(2.0f * radius), color, FL_ELEMENT_TYPE_RING_INDEX, std::min(thickness, radius));
+    }
+
+    void Renderer::AddRoundedRect(const glm::vec3& position, const glm::vec2& dimensions, float cornerRadius, const glm::vec4& color)
+    {
+        AddShape(position, dimensions, color, FL_ELEMENT_TYPE_ROUNDED_RECT_INDEX, std::min(cornerRadius, std::min(dimensions.x, dimensions.y) / 2.0f));
+    }
+
+    void Renderer::AddLine(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color)
+    {
+        AddSegment(start, end, z, thickness, color, FL_ELEMENT_TYPE_LINE_INDEX);
+    }
+
+    void Renderer::AddCapsule(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color)
+    {
+        AddSegment(start, end, z, thickness, color, FL_ELEMENT_TYPE_CAPSULE_INDEX);
+    }
+
+    void Renderer::AddSegment(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color, const float elementTypeIndex)
+    {
+        // Padding the segment by half its thickness on every side bounds it at any angle, the ends are then two opposite corners of the quad shrunk by that much.
+        // The shader only needs to know which of the two diagonals the segment runs along
+        glm::vec2 delta = { end.x - start.x, end.y - start.y };
+        glm::vec3 center = { (start.x + end.x) / 2.0f, (start.y + end.y) / 2.0f, z };
+        bool isDescending = (delta.x < 0.0f) != (delta.y < 0.0f) && delta.x != 0.0f && delta.y != 0.0f;
+        AddShape(center, { std::abs(delta.x) + thickness, std::abs(delta.y) + thickness }, color, elementTypeIndex, thickness, isDescending);
     }
 
     void Renderer::AddQuad(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, const char* textureFilePath, UnitType unitType, bool isPanelActive)
     {
-        Vertex vertices[4];
-        vertices[0].texture_uv = { 0.0f, 0.0f };
-        vertices[1].texture_uv = { 0.0f, 1.0f };
-        vertices[2].texture_uv = { 1.0f, 1.0f };
-        vertices[3].texture_uv = { 1.0f, 0.0f };
+        FL_ASSERT(s_RetainedBatch.RecordingRangeId == FL_INVALID_RETAINED_RANGE, "Textured quads can't be added to a retained range!");
+        if (!IsQuadVisible(position, dimensions, unitType))
+            return;
 
-        glm::mat4 transformation{ 1.0f };
+        // A texture seen for the first time is streamed in the background, the quad draws the placeholder in the meantime
+        const TextureLocation* texture = &s_TextureCache->Get(textureFilePath, s_FrameIndex);
 
-        switch (unitType)
+        PrepareBatchForQuad();
+        // A texture which couldn't be stored in the pool is drawn as an untextured quad
+        float textureSlot = texture->ArrayTextureId ? GetBatchTextureSlot(texture->ArrayTextureId) : -1.0f;
+        AddQuadInstance(position, dimensions, color, elementTypeIndex, textureSlot, unitType, isPanelActive, FL_STYLE_NONE_INDEX, texture);
+    }
+
+    float Renderer::GetBatchTextureSlot(uint32_t arrayTextureId)
+    {
+        // Quads of textures in the same texture array share its slot, so the batch is only flushed once more texture arrays than slots are used
+        auto it = std::find(s_Batch.TextureIds.begin(), s_Batch.TextureIds.end(), arrayTextureId);
+        if (it != s_Batch.TextureIds.end())
+            return (float)(it - s_Batch.TextureIds.begin());
+
+        if (s_Batch.TextureIds.size() == s_TextureSlotCount)
+            FlushBatch();
+        s_Batch.TextureIds.push_back(arrayTextureId);
+        return (float)(s_Batch.TextureIds.size() - 1);
+    }
+
+    void Renderer::AddText(const std::string& text, const glm::vec3& position_in_pixels, float scale, const glm::vec4& color, float maxWidth)
+    {
+        if (!s_TextLayoutCache)
+            return;
+        AddText(*s_TextLayoutCache->GetLayout(text, scale, maxWidth), position_in_pixels, color);
+    }
+
+    void Renderer::AddText(const TextLayout& layout, const glm::vec3& position_in_pixels, const glm::vec4& color)
+    {
+        uint32_t packedColor = PackColor(color);
+
+        for (const auto& glyph : layout.glyphs)
         {
-            case UnitType::PIXEL_UNITS:
-                transformation = glm::translate(glm::mat4(1.0f), { ConvertPixelsToOpenGLValues({ position.x, position.y }), position.z });
-                transformation = glm::scale(transformation, { ConvertPixelsToOpenGLValues(dimensions), 0.0f });
-                break;
-            case UnitType::OPENGL_UNITS:
-                transformation = glm::translate(glm::mat4(1.0f), position);
-                transformation = glm::scale(transformation, { dimensions, 0.0f });
-                break;
-            default:
-                break;
+            // The layout only stores where the glyph goes, its place in the atlas can change whenever an atlas page is evicted
+            const flame::character* character = GetCharacter(glyph.codepoint);
+            if (!character)
+                continue;
+
+            glm::vec2 glyphPosition = { position_in_pixels.x + glyph.position.x, position_in_pixels.y + glyph.position.y };
+            if (!IsRect2DVisible({ glyphPosition.x, glyphPosition.x + glyph.size.x, glyphPosition.y, glyphPosition.y + glyph.size.y }))
+            {
+                s_RejectedQuadCount++;
+                continue;
+            }
+
+            if (s_TextBatch.Instances.size() == MAX_TEXT_BATCH_GLYPHS)
+                FlushTextBatch();
+
+            GlyphInstance instance;
+            instance.position = { glyphPosition, position_in_pixels.z };
+            instance.dimensions = glyph.size;
+            instance.texture_uv_rect = { character->uvMin.x, character->uvMin.y, character->uvMax.x, character->uvMax.y };
+            instance.color = packedColor;
+            instance.atlas_page = (float)character->atlasPage;
+            std::copy(s_PackedClipRect.begin(), s_PackedClipRect.end(), instance.clip_rect);
+            s_TextBatch.Instances.push_back(instance);
         }
+    }
+
+    void Renderer::Begin()
+    {
+        OnUpdate();
+        s_RejectedQuadCount = 0;
+        s_QuadDrawCallCount = 0;
+        // The placeholder may have been drawn anywhere, the textured quads are only known once they are added again
+        if (s_TextureCache->Update(s_FrameIndex))
+            s_PartialRedraw.IsFullRedrawNeeded = true;
+
+        /* Set Projection Matrix in GPU memory, for all shader programs to access it */
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, s_UniformBufferId);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(s_UniformBufferData.ProjectionMatrix));
 
-        for (uint8_t i = 0; i < 4; i++)
+        if (s_IsThemeDirty)
+            UploadTheme();
+    }
+
+    void Renderer::InvalidateViewportDependentState()
+    {
+        // All geometry is in pixels and only the projection depends on the viewport, so the retained quads and the theme stay valid.
+        // The back buffer is resized before the next draw, which has to redraw all of it
+        s_PartialRedraw.IsFullRedrawNeeded = true;
+    }
+
+    void Renderer::PushClipRect(const Rect2D& rect_in_pixels)
+    {
+        Rect2D clipRect = rect_in_pixels;
+        if (!s_ClipRects.empty())
+        {
+            const Rect2D& parentClipRect = s_ClipRects.back();
+            clipRect.l = std::max(clipRect.l, parentClipRect.l);
+            clipRect.r = std::min(clipRect.r, parentClipRect.r);
+            clipRect.b = std::max(clipRect.b, parentClipRect.b);
+            clipRect.t = std::min(clipRect.t, parentClipRect.t);
+        }
+        // Disjoint rectangles intersect in an empty rectangle, which is collapsed rather than left inside out
+        clipRect.r = std::max(clipRect.r, clipRect.l);
+        clipRect.t = std::max(clipRect.t, clipRect.b);
+        s_ClipRects.push_back(clipRect);
+        PackClipRect();
+    }
+
+    void Renderer::PopClipRect()
+    {
+        FL_ASSERT(!s_ClipRects.empty(), "Renderer::PopClipRect() was called without a matching Renderer::PushClipRect()!");
+        s_ClipRects.pop_back();
+        PackClipRect();
+    }
+
+    void Renderer::PackClipRect()
+    {
+        if (s_ClipRects.empty())
         {
-            vertices[i].position = transformation * s_TemplateVertexPositions[i];
-            vertices[i].element_type_index = elementTypeIndex;
-            vertices[i].color = color;
-            vertices[i].quad_dimensions = ConvertPixelsToOpenGLValues(dimensions);
-            vertices[i].texture_index = s_CurrentTextureSlot;
-            vertices[i].is_panel_active = isPanelActive ? 1.0f : 0.0f;
+            s_PackedClipRect = { -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT, -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT };
+            return;
         }
 
-        for (uint8_t i = 0; i < 4; i++)
-            s_Batch.Vertices.push_back(vertices[i]);
+        // Rounded outwards, so that the clipped quads never lose a partially covered pixel
+        const Rect2D& clipRect = s_ClipRects.back();
+        auto packExtent = [](float value) { return (int16_t)std::clamp(value, (float)-FL_UNCLIPPED_EXTENT, (float)FL_UNCLIPPED_EXTENT); };
+        s_PackedClipRect = { packExtent(std::floor(clipRect.l)), packExtent(std::ceil(clipRect.r)), packExtent(std::floor(clipRect.b)), packExtent(std::ceil(clipRect.t)) };
+    }
 
-        uint32_t textureId = GetTextureIdIfAvailable(textureFilePath);
-        if (!textureId)
+    bool Renderer::IsRect2DVisible(const Rect2D& rect_in_pixels)
+    {
+        // Rectangles touching the clip rectangle only along an edge produce no fragments, so they are rejected too
+        if (!s_ClipRects.empty())
         {
-            textureId = CreateTexture(textureFilePath);
-            s_TextureIdCache[textureFilePath] = textureId;
+            const Rect2D& clipRect = s_ClipRects.back();
+            if (clipRect.r <= clipRect.l || clipRect.t <= clipRect.b)
+                return false;
+            if (rect_in_pixels.r <= clipRect.l || rect_in_pixels.l >= clipRect.r || rect_in_pixels.t <= clipRect.b || rect_in_pixels.b >= clipRect.t)
+                return false;
         }
-        s_Batch.TextureIds.push_back(textureId);
 
-        // Increment the texture slot every time a textured quad is added
-        s_CurrentTextureSlot++;
-        if (s_CurrentTextureSlot == MAX_TEXTURE_SLOTS)
+        if (s_RetainedBatch.RecordingRangeId != FL_INVALID_RETAINED_RANGE)
+            return true;
+
+        glm::vec2 halfViewportInPixels = s_ViewportSize / s_WindowContentScale / 2.0f;
+        return rect_in_pixels.r > -halfViewportInPixels.x && rect_in_pixels.l < halfViewportInPixels.x && rect_in_pixels.t > -halfViewportInPixels.y && rect_in_pixels.b < halfViewportInPixels.y;
+    }
+
+    bool Renderer::IsQuadVisible(const glm::vec3& position, const glm::vec2& dimensions, UnitType unitType)
+    {
+        glm::vec2 center = position, halfDimensions = dimensions / 2.0f;
+        if (unitType == UnitType::OPENGL_UNITS)
         {
-            FlushBatch();
-            s_CurrentTextureSlot = 0;
+            glm::vec2 openGLUnitsPerPixel = ConvertPixelsToOpenGLValues(glm::vec2(1.0f));
+            center = center / openGLUnitsPerPixel;
+            halfDimensions = halfDimensions / openGLUnitsPerPixel;
+        }
+
+        if (IsRect2DVisible({ center.x - halfDimensions.x, center.x + halfDimensions.x, center.y - halfDimensions.y, center.y + halfDimensions.y }))
+            return true;
+        s_RejectedQuadCount++;
+        return false;
+    }
+
+    size_t Renderer::RemoveInvisibleInstances(QuadInstance* instances, size_t instanceCount)
+    {
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < instanceCount; i++)
+        {
+            const QuadInstance& instance = instances[i];
+            glm::vec2 halfDimensions = instance.dimensions / 2.0f;
+            if (!IsRect2DVisible({ instance.position.x - halfDimensions.x, instance.position.x + halfDimensions.x, instance.position.y - halfDimensions.y, instance.position.y + halfDimensions.y }))
+                continue;
+            if (visibleCount != i)
+                instances[visibleCount] = instance;
+            visibleCount++;
+        }
+        s_RejectedQuadCount += (uint32_t)(instanceCount - visibleCount);
+        return visibleCount;
+    }
+
+    void Renderer::AddDamageRect(const Rect2D& rect_in_pixels)
+    {
+        if (!s_PartialRedraw.IsEnabled || rect_in_pixels.l >= rect_in_pixels.r || rect_in_pixels.b >= rect_in_pixels.t)
+            return;
+
+        // All the damage of a frame is merged into a single bounding rectangle, which is redrawn using one scissor rectangle
+        Rect2D& bounds = s_PartialRedraw.DamageBounds;
+        if (!s_PartialRedraw.HasDamage)
+            bounds = rect_in_pixels;
+        else
+        {
+            bounds.l = std::min(bounds.l, rect_in_pixels.l);
+            bounds.r = std::max(bounds.r, rect_in_pixels.r);
+            bounds.b = std::min(bounds.b, rect_in_pixels.b);
+            bounds.t = std::max(bounds.t, rect_in_pixels.t);
+        }
+        s_PartialRedraw.HasDamage = true;
+    }
+
+    void Renderer::PrepareFrameForDrawing(bool isEndOfFrame)
+    {
+        auto& partialRedraw = s_PartialRedraw;
+        if (!partialRedraw.IsEnabled || partialRedraw.IsFrameDrawPrepared)
+            return;
+        partialRedraw.IsFrameDrawPrepared = true;
+
+        if (partialRedraw.BackBuffer->GetFramebufferSize() != s_ViewportSize)
+        {
+            partialRedraw.BackBuffer->SetFramebufferSize(s_ViewportSize.x, s_ViewportSize.y);
+            partialRedraw.BackBuffer->OnUpdate();
+            partialRedraw.IsFullRedrawNeeded = true;
+        }
+        partialRedraw.BackBuffer->Bind();
+        glClearColor(s_ThemeInfo.windowBgColor.x, s_ThemeInfo.windowBgColor.y, s_ThemeInfo.windowBgColor.z, s_ThemeInfo.windowBgColor.w);
+
+        // Convert the damage bounds from centered pixel units to framebuffer pixels, padded by a pixel for the antialiased edges
+        float left = 0.0f, right = 0.0f, bottom = 0.0f, top = 0.0f;
+        if (partialRedraw.HasDamage)
+        {
+            const Rect2D& bounds = partialRedraw.DamageBounds;
+            left = std::clamp(std::floor(bounds.l * s_WindowContentScale.x + s_ViewportSize.x / 2.0f) - 1.0f, 0.0f, s_ViewportSize.x);
+            right = std::clamp(std::ceil(bounds.r * s_WindowContentScale.x + s_ViewportSize.x / 2.0f) + 1.0f, 0.0f, s_ViewportSize.x);
+            bottom = std::clamp(std::floor(bounds.b * s_WindowContentScale.y + s_ViewportSize.y / 2.0f) - 1.0f, 0.0f, s_ViewportSize.y);
+            top = std::clamp(std::ceil(bounds.t * s_WindowContentScale.y + s_ViewportSize.y / 2.0f) + 1.0f, 0.0f, s_ViewportSize.y);
+        }
+        float damagedArea = (right - left) * (top - bottom);
+
+        if (partialRedraw.IsFullRedrawNeeded || !isEndOfFrame || damagedArea > partialRedraw.FullRedrawThreshold * s_ViewportSize.x * s_ViewportSize.y)
+        {
+            GLState::SetCapability(GL_SCISSOR_TEST, false);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+        else if (damagedArea <= 0.0f)
+            partialRedraw.IsFrameDrawSkipped = true;
+        else
+        {
+            // Everything outside of the scissor rectangle keeps the pixels of the previous frames
+            GLState::SetCapability(GL_SCISSOR_TEST, true);
+            GLState::Scissor((GLint)left, (GLint)bottom, (GLsizei)(right - left), (GLsizei)(top - bottom));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
     }
 
-    void Renderer::AddText(const std::string& text, const glm::vec2& position_in_pixels, float scale, const glm::vec4& color)
+    void Renderer::FinishFrameDrawing()
     {
-        static uint16_t slot = 0;
-        auto position = position_in_pixels;
+        auto& partialRedraw = s_PartialRedraw;
+        if (!partialRedraw.IsEnabled)
+            return;
 
-        for (std::string::const_iterator it = text.begin(); it != text.end(); it++)
+        GLState::SetCapability(GL_SCISSOR_TEST, false);
+        GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, partialRedraw.BackBuffer->GetFramebufferId());
+        GLState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, (GLint)s_ViewportSize.x, (GLint)s_ViewportSize.y, 0, 0, (GLint)s_ViewportSize.x, (GLint)s_ViewportSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::Viewport(0, 0, s_ViewportSize.x, s_ViewportSize.y);
+
+        partialRedraw.HasDamage = false;
+        partialRedraw.IsFullRedrawNeeded = false;
+        partialRedraw.IsFrameDrawPrepared = false;
+        partialRedraw.IsFrameDrawSkipped = false;
+    }
+
+    uint32_t Renderer::CreateRetainedRange()
+    {
+        if (s_RetainedBatch.FreeRangeIds.size())
         {
-            flame::character character = s_Characters[*it];
+            uint32_t rangeId = s_RetainedBatch.FreeRangeIds.back();
+            s_RetainedBatch.FreeRangeIds.pop_back();
+            return rangeId;
+        }
+        s_RetainedBatch.Ranges.emplace_back();
+        return (uint32_t)s_RetainedBatch.Ranges.size() - 1;
+    }
 
-            float xpos = position.x + character.bearing.x * scale;
-            float ypos = position.y - (character.size.y - character.bearing.y) * scale - s_FontProps.DescenderY * scale;
+    void Renderer::DestroyRetainedRange(uint32_t rangeId)
+    {
+        // The ranges are already gone when panels are destroyed after `CleanUp()`
+        if (rangeId >= s_RetainedBatch.Ranges.size())
+            return;
+        FL_ASSERT(s_RetainedBatch.RecordingRangeId != rangeId, "Retained range {0} is destroyed while it is being recorded!", rangeId);
 
-            float w = character.size.x * scale;
-            float h = character.size.y * scale;
+        RetainedRange& range = s_RetainedBatch.Ranges[rangeId];
+        if (range.Count)
+        {
+            std::fill(s_RetainedBatch.Instances.begin() + range.Offset, s_RetainedBatch.Instances.begin() + range.Offset + range.Count, QuadInstance());
+            UploadRetainedInstances(range.Offset, range.Count);
+        }
 
-            std::array<FlameUI::Vertex, 4> vertices;
-            vertices[0].position = { xpos,     ypos,     0.0f };
-            vertices[1].position = { xpos,     ypos + h, 0.0f };
-            vertices[2].position = { xpos + w, ypos + h, 0.0f };
-            vertices[3].position = { xpos + w, ypos,     0.0f };
+        // Without any capacity the slots of the range don't count as used anymore, so they are dropped by the next compaction
+        range = RetainedRange();
+        s_RetainedBatch.FreeRangeIds.push_back(rangeId);
+        ReserveRetainedInstances();
+    }
 
-            for (auto& vertex : vertices)
+    bool Renderer::IsRetainedRangeValid(uint32_t rangeId)
+    {
+        return rangeId < s_RetainedBatch.Ranges.size() && s_RetainedBatch.Ranges[rangeId].IsValid;
+    }
+
+    void Renderer::BeginRetainedRange(uint32_t rangeId)
+    {
+        FL_ASSERT(rangeId < s_RetainedBatch.Ranges.size(), "Invalid retained range id: {0}", rangeId);
+        FL_ASSERT(s_RetainedBatch.RecordingRangeId == FL_INVALID_RETAINED_RANGE, "Retained range {0} is already being recorded!", s_RetainedBatch.RecordingRangeId);
+        s_RetainedBatch.RecordingRangeId = rangeId;
+        s_RetainedBatch.RecordedInstances.clear();
+    }
+
+    void Renderer::EndRetainedRange()
+    {
+        FL_ASSERT(s_RetainedBatch.RecordingRangeId != FL_INVALID_RETAINED_RANGE, "Renderer::BeginRetainedRange() wasn't called!");
+
+        RetainedRange& range = s_RetainedBatch.Ranges[s_RetainedBatch.RecordingRangeId];
+        s_RetainedBatch.RecordingRangeId = FL_INVALID_RETAINED_RANGE;
+
+        const auto& recordedInstances = s_RetainedBatch.RecordedInstances;
+        uint32_t recordedCount = (uint32_t)recordedInstances.size();
+        bool isFullyUploaded = false;
+
+        if (recordedCount > range.Capacity)
+        {
+            // The old slots are left behind as degenerate quads and the range moves to the end of the buffer, with room to grow
+            std::fill(s_RetainedBatch.Instances.begin() + range.Offset, s_RetainedBatch.Instances.begin() + range.Offset + range.Count, QuadInstance());
+            if (range.Count)
+                UploadRetainedInstances(range.Offset, range.Count);
+
+            uint32_t capacity = 4;
+            while (capacity < recordedCount)
+                capacity *= 2;
+
+            range.Offset = s_RetainedBatch.AllocatedCount;
+            range.Count = 0;
+            range.Capacity = capacity;
+            s_RetainedBatch.AllocatedCount += capacity;
+            s_RetainedBatch.Instances.resize(s_RetainedBatch.AllocatedCount);
+
+            isFullyUploaded = ReserveRetainedInstances();
+        }
+
+        // Slots that the range doesn't use anymore are turned into degenerate quads
+        std::copy(recordedInstances.begin(), recordedInstances.end(), s_RetainedBatch.Instances.begin() + range.Offset);
+        if (range.Count > recordedCount)
+            std::fill(s_RetainedBatch.Instances.begin() + range.Offset + recordedCount, s_RetainedBatch.Instances.begin() + range.Offset + range.Count, QuadInstance());
+
+        if (!isFullyUploaded)
+            UploadRetainedInstances(range.Offset, std::max(range.Count, recordedCount));
+
+        range.Count = recordedCount;
+        range.IsValid = true;
+        s_RetainedBatch.IsOrderDirty = true;
+        s_RetainedBatch.IsChangedAfterOpaquePass |= s_RetainedBatch.IsOpaquePassDrawn;
+    }
+
+    bool Renderer::ReserveRetainedInstances()
+    {
+        auto& retainedBatch = s_RetainedBatch;
+
+        uint32_t usedCount = 0;
+        for (const auto& range : retainedBatch.Ranges)
+            usedCount += range.Capacity;
+
+        // Ranges that grew leave holes behind, once they take up most of the buffer the ranges are packed together again
+        bool isCompacted = false;
+        if (retainedBatch.AllocatedCount > 2 * usedCount)
+        {
+            std::vector<QuadInstance> instances(usedCount);
+            uint32_t offset = 0;
+            for (auto& range : retainedBatch.Ranges)
             {
-                vertex.position.x = ConvertXAxisPixelValueToOpenGLValue(vertex.position.x);
-                vertex.position.y = ConvertYAxisPixelValueToOpenGLValue(vertex.position.y);
+                std::copy(retainedBatch.Instances.begin() + range.Offset, retainedBatch.Instances.begin() + range.Offset + range.Count, instances.begin() + offset);
+                range.Offset = offset;
+                offset += range.Capacity;
             }
+            retainedBatch.Instances = std::move(instances);
+            retainedBatch.AllocatedCount = usedCount;
+            isCompacted = true;
+            retainedBatch.IsOrderDirty = true;
+        }
 
-            vertices[0].texture_uv = { 0.0f, 0.0f };
-            vertices[1].texture_uv = { 0.0f, 1.0f };
-            vertices[2].texture_uv = { 1.0f, 1.0f };
-            vertices[3].texture_uv = { 1.0f, 0.0f };
+        if (retainedBatch.AllocatedCount > retainedBatch.BufferCapacity)
+        {
+            uint32_t bufferCapacity = std::max(retainedBatch.BufferCapacity, (uint32_t)INITIAL_BATCH_QUADS);
+            while (bufferCapacity < retainedBatch.AllocatedCount)
+                bufferCapacity *= 2;
+
+            GLState::BindBuffer(GL_ARRAY_BUFFER, retainedBatch.InstanceBufferId);
+            glBufferData(GL_ARRAY_BUFFER, (size_t)bufferCapacity * sizeof(QuadInstance), nullptr, GL_DYNAMIC_DRAW);
+            retainedBatch.BufferCapacity = bufferCapacity;
+            FL_INFO("Grew retained quad buffer capacity to {0} quads", bufferCapacity);
+        }
+        else if (!isCompacted)
+            return false;
 
-            for (auto& vertex : vertices)
-                vertex.texture_index = (float)slot;
+        UploadRetainedInstances(0, retainedBatch.AllocatedCount);
+        return true;
+    }
 
-            slot++;
-            if (slot == MAX_TEXTURE_SLOTS)
-                slot = 0;
+    void Renderer::UploadRetainedInstances(uint32_t firstInstance, uint32_t instanceCount)
+    {
+        if (!instanceCount)
+            return;
+        GLState::BindBuffer(GL_ARRAY_BUFFER, s_RetainedBatch.InstanceBufferId);
+        glBufferSubData(GL_ARRAY_BUFFER, (size_t)firstInstance * sizeof(QuadInstance), (size_t)instanceCount * sizeof(QuadInstance), &s_RetainedBatch.Instances[firstInstance]);
+    }
+
+    void Renderer::DrawRetainedBatch(QuadAlphaPass alphaPass)
+    {
+        if (alphaPass == QuadAlphaPass::OPAQUE_FRAGMENTS)
+        {
+            s_RetainedBatch.IsOpaquePassDrawn = true;
+            s_RetainedBatch.IsChangedAfterOpaquePass = false;
+        }
+        if (!s_RetainedBatch.AllocatedCount)
+            return;
+
+        PrepareFrameForDrawing(false);
+        if (s_PartialRedraw.IsFrameDrawSkipped)
+            return;
 
-            for (uint8_t i = 0; i < 4; i++)
-                vertices[i].color = color;
+        // Every range holds the quads of one panel recorded from back to front, so with the ranges in order a single draw blends all of them in order, holes included
+        OrderRetainedRanges();
+        GLState::BindVertexArray(s_RetainedBatch.VertexArrayId);
+        SetQuadAlphaPass(alphaPass);
+        const bool isTranslucentPass = alphaPass == QuadAlphaPass::TRANSLUCENT_FRAGMENTS;
+        if (isTranslucentPass)
+            GLState::DepthMask(false);
+        DrawQuadInstances(s_RetainedBatch.Instances.data(), 0, s_RetainedBatch.AllocatedCount, s_RetainedBatch.InstanceBufferId);
+        if (isTranslucentPass)
+            GLState::DepthMask(true);
+        SetQuadAlphaPass(QuadAlphaPass::ALL_FRAGMENTS);
+    }
 
-            // AddQuadToTextBatch(nullptr, vertices, character.textureId);
-            position.x += (character.advance) * scale + 1.0f;
+    void Renderer::OrderRetainedRanges()
+    {
+        auto& retainedBatch = s_RetainedBatch;
+        if (!retainedBatch.IsOrderDirty)
+            return;
+        retainedBatch.IsOrderDirty = false;
+
+        // Destroyed ranges have no slots and are left out, empty ranges have no depth and go first
+        auto& rangeIds = retainedBatch.OrderedRangeIds;
+        rangeIds.clear();
+        for (uint32_t rangeId = 0; rangeId < (uint32_t)retainedBatch.Ranges.size(); rangeId++)
+        {
+            if (retainedBatch.Ranges[rangeId].Capacity)
+                rangeIds.push_back(rangeId);
+        }
+        auto getRangeDepth = [&retainedBatch](uint32_t rangeId) {
+            const RetainedRange& range = retainedBatch.Ranges[rangeId];
+            return range.Count ? retainedBatch.Instances[range.Offset].position.z : -std::numeric_limits<float>::max();
+        };
+        std::stable_sort(rangeIds.begin(), rangeIds.end(), [&getRangeDepth](uint32_t a, uint32_t b) { return getRangeDepth(a) < getRangeDepth(b); });
+
+        uint32_t usedCount = 0;
+        bool isOrdered = true;
+        for (uint32_t rangeId : rangeIds)
+        {
+            const RetainedRange& range = retainedBatch.Ranges[rangeId];
+            isOrdered &= range.Offset >= usedCount;
+            usedCount = isOrdered ? range.Offset + range.Capacity : usedCount + range.Capacity;
+        }
+        if (isOrdered)
+            return;
+
+        // Happens when a panel changes its draw order or outgrows its range, so the whole buffer is uploaded rather than tracking which ranges moved
+        usedCount = 0;
+        for (uint32_t rangeId : rangeIds)
+            usedCount += retainedBatch.Ranges[rangeId].Capacity;
+
+        std::vector<QuadInstance> instances(usedCount);
+        uint32_t offset = 0;
+        for (uint32_t rangeId : rangeIds)
+        {
+            RetainedRange& range = retainedBatch.Ranges[rangeId];
+            std::copy(retainedBatch.Instances.begin() + range.Offset, retainedBatch.Instances.begin() + range.Offset + range.Count, instances.begin() + offset);
+            range.Offset = offset;
+            offset += range.Capacity;
         }
+        retainedBatch.Instances = std::move(instances);
+        retainedBatch.AllocatedCount = usedCount;
+        UploadRetainedInstances(0, retainedBatch.AllocatedCount);
     }
 
-    void Renderer::Begin()
+    void Renderer::SetQuadAlphaPass(QuadAlphaPass alphaPass)
     {
-        OnUpdate();
+        if (s_Batch.AlphaPass == alphaPass)
+            return;
+        s_Batch.AlphaPass = alphaPass;
 
-        /* Set Projection Matrix in GPU memory, for all shader programs to access it */
-        glBindBuffer(GL_UNIFORM_BUFFER, s_UniformBufferId);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(s_UniformBufferData.ProjectionMatrix));
+        // The programs which aren't used by the current strategy always stay at `QuadAlphaPass::ALL_FRAGMENTS`, as every pass is reset to it right after drawing
+        if (s_Batch.ShaderStrategy == QuadShaderStrategy::UBER_SHADER)
+        {
+            GLState::UseProgram(s_Batch.ShaderProgramId);
+            glUniform1i(GetUniformLocation(s_AlphaPassUniform, s_Batch.ShaderProgramId), (int)alphaPass);
+            return;
+        }
+        for (uint32_t programId : s_Batch.VariantShaderProgramIds)
+        {
+            GLState::UseProgram(programId);
+            glUniform1i(GetUniformLocation(s_AlphaPassUniform, programId), (int)alphaPass);
+        }
+    }
+
+    void Renderer::DrawQuadInstances(const QuadInstance* instances, uint32_t firstInstance, uint32_t instanceCount, uint32_t instanceBufferId)
+    {
+        // Without a base instance the attributes are pointed at the first quad of every run instead, and pointed back at the start of the buffer afterwards
+        const bool hasBaseInstance = GLAD_GL_VERSION_4_2;
+        bool areAttributesOffset = false;
+
+        uint32_t runStart = 0;
+        while (runStart < instanceCount)
+        {
+            // The uber shader draws all the quads as a single run
+            uint32_t programId = s_Batch.ShaderProgramId, runEnd = instanceCount;
+            if (s_Batch.ShaderStrategy == QuadShaderStrategy::SPECIALIZED_VARIANTS)
+            {
+                // A quad with an invalid element type has no variant, its run is drawn by the uber shader instead
+                uint8_t elementType = instances[runStart].element_type_index;
+                FL_ASSERT(elementType < FL_ELEMENT_TYPE_COUNT, "Quad has an invalid element type {0}!", elementType);
+                if (elementType < FL_ELEMENT_TYPE_COUNT)
+                    programId = s_Batch.VariantShaderProgramIds[elementType];
+
+                // Quads without an area, e.g. the unused slots of retained ranges, produce no fragments and join whichever run they are in
+                runEnd = runStart + 1;
+                while (runEnd < instanceCount && (instances[runEnd].element_type_index == elementType || instances[runEnd].dimensions.x == 0.0f || instances[runEnd].dimensions.y == 0.0f))
+                    runEnd++;
+            }
+
+            GLState::UseProgram(programId);
+            if (hasBaseInstance || !(firstInstance + runStart))
+                DrawInstancedQuads(firstInstance + runStart, runEnd - runStart);
+            else
+            {
+                GLState::BindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+                SetupQuadInstanceAttributes(firstInstance + runStart);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)(runEnd - runStart));
+                areAttributesOffset = true;
+            }
+            s_QuadDrawCallCount++;
+            runStart = runEnd;
+        }
+
+        if (areAttributesOffset)
+            SetupQuadInstanceAttributes(0);
+    }
+
+    void Renderer::SetThemeInfo(const ThemeInfo& themeInfo)
+    {
+        s_ThemeInfo = themeInfo;
+        s_IsThemeDirty = true;
+        s_ThemeRevision++;
+        s_PartialRedraw.IsFullRedrawNeeded = true;
+    }
+
+    void Renderer::UploadTheme()
+    {
+        ThemeUniformBufferData themeData{};
+        themeData.PanelBgColor = s_ThemeInfo.panelBgColor;
+        themeData.PanelTitleBarActiveColor = s_ThemeInfo.panelTitleBarActiveColor;
+        themeData.PanelTitleBarInactiveColor = s_ThemeInfo.panelTitleBarInactiveColor;
+        themeData.BorderColor = s_ThemeInfo.borderColor;
+        themeData.StyleColors[FL_STYLE_NONE_INDEX] = glm::vec4(1.0f);
+        themeData.StyleColors[FL_STYLE_BUTTON_INDEX] = s_ThemeInfo.buttonColor;
+        themeData.StyleColors[FL_STYLE_BUTTON_HOVERED_INDEX] = s_ThemeInfo.buttonHoveredColor;
+        themeData.StyleColors[FL_STYLE_BUTTON_PRESSED_INDEX] = s_ThemeInfo.buttonPressedColor;
+        themeData.TitleBarHeight = TITLE_BAR_HEIGHT;
+        themeData.PanelBorderWidth = s_ThemeInfo.panelBorderWidth;
+        themeData.PanelCornerRadius = s_ThemeInfo.panelCornerRadius;
+        themeData.PanelShadowBlurSigma = s_ThemeInfo.panelShadowBlurSigma;
+        themeData.PanelShadowColor = s_ThemeInfo.panelShadowColor;
+        themeData.PanelShadowOffset = s_ThemeInfo.panelShadowOffset;
+
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, s_ThemeUniformBufferId);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ThemeUniformBufferData), &themeData);
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, s_UniformBufferId);
+        s_IsThemeDirty = false;
     }
 
     void Renderer::End()
     {
+        FL_ASSERT(s_ClipRects.empty(), "Renderer::PopClipRect() wasn't called for {0} clip rectangles!", s_ClipRects.size());
+        FL_ASSERT(s_RetainedBatch.RecordingRangeId == FL_INVALID_RETAINED_RANGE, "Renderer::EndRetainedRange() wasn't called for retained range {0}!", s_RetainedBatch.RecordingRangeId);
+        // The whole frame is submitted by now, so the damage is known and only the damaged region has to be redrawn
+        PrepareFrameForDrawing(true);
+        // Ranges recorded after an overflow flush drew the opaque pass are only up to date once it is drawn again
+        if (!s_RetainedBatch.IsOpaquePassDrawn || s_RetainedBatch.IsChangedAfterOpaquePass)
+            DrawRetainedBatch(QuadAlphaPass::OPAQUE_FRAGMENTS);
         FlushBatch();
-        s_CurrentTextureSlot = 0;
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        // The text writes depth before the translucent fragments of the panels are blended, so that the shadows and edges of the panels in front cover the text behind them
+        FlushTextBatch();
+        DrawRetainedBatch(QuadAlphaPass::TRANSLUCENT_FRAGMENTS);
+        FinishFrameDrawing();
+        s_RetainedBatch.IsOpaquePassDrawn = false;
+        s_RetainedBatch.IsChangedAfterOpaquePass = false;
+        s_Batch.InstanceRing->OnFrameEnd();
+        if (s_TextBatch.InstanceRing)
+            s_TextBatch.InstanceRing->OnFrameEnd();
+        GLState::BindBuffer(GL_UNIFORM_BUFFER, 0);
+        s_FrameIndex++;
+        if (s_TextLayoutCache)
+            s_TextLayoutCache->OnFrameEnd();
+
+        // Grow the batch from the observed peak usage, so that the following frames fit in a single draw call again
+        s_Batch.PeakQuadCount = std::max(s_Batch.PeakQuadCount, s_Batch.FrameQuadCount);
+        s_Batch.FrameQuadCount = 0;
+        if (s_Batch.PeakQuadCount > s_Batch.QuadCapacity && s_Batch.QuadCapacity < MAX_BATCH_QUADS)
+        {
+            uint32_t quadCapacity = s_Batch.QuadCapacity;
+            while (quadCapacity < s_Batch.PeakQuadCount && quadCapacity < MAX_BATCH_QUADS)
+                quadCapacity *= 2;
+            quadCapacity = std::min(quadCapacity, (uint32_t)MAX_BATCH_QUADS);
+
+            ResizeBatch(quadCapacity);
+            FL_INFO("Grew quad batch capacity to {0} quads (peak usage: {1} quads)", quadCapacity, s_Batch.PeakQuadCount);
+        }
     }
 
     void Renderer::LoadFont(const std::string& filePath)
     {
+        double border_width = s_FontProps.BorderWidth;
+
+        // The generated atlas only depends on the font file contents and the generation parameters
+        GlyphAtlasCacheKey cacheKey{};
+        {
+            MappedFile fontFile(filePath);
+            FL_ASSERT(fontFile.IsOpen(), "Failed to open font file: {0}", filePath);
+            cacheKey.FontContentHash = HashBytes(fontFile.GetData(), fontFile.GetSize());
+            s_FontProps.ContentHash = cacheKey.FontContentHash;
+            cacheKey.PixelRange = s_FontProps.PixelRange;
+            cacheKey.BorderWidth = (float)border_width;
+        }
+
+        std::string cacheFilePath = "";
+        if (!s_FontCacheDirectory.empty())
+        {
+            cacheFilePath = s_FontCacheDirectory + std::filesystem::path(filePath).filename().string() + ".glyphcache";
+            if (LoadFontFromCache(cacheFilePath, cacheKey))
+                return;
+        }
+
         msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
         FL_ASSERT(ft, "Failed to initialize Font Handle!");
 
         msdfgen::FontHandle* msdffontHandle = loadFont(ft, filePath.c_str());
         FL_ASSERT(msdffontHandle, "Failed to load font from the file path: {0}", filePath);
 
-        double border_width = 2.0;
-
         msdfgen::FontMetrics metrics;
         msdfgen::getFontMetrics(metrics, msdffontHandle);
         s_FontProps.AscenderY = metrics.ascenderY;
         s_FontProps.DescenderY = metrics.descenderY;
 
-        for (uint8_t character = 32; character < 128; character++)
+        // Generate all the preloaded glyph bitmaps first, so that they can be packed tallest first
+        // The glyphs are generated by the worker threads, only the final upload of the atlas happens on this thread
+        std::vector<GlyphBitmap> glyphBitmaps(128 - 32);
+        std::atomic<uint32_t> nextGlyphIndex = 0;
+        std::atomic<int64_t> glyphWorkDurationInNanoseconds = 0;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        uint32_t workerCount = std::min(s_WorkerPool->GetThreadCount(), (uint32_t)glyphBitmaps.size());
+        for (uint32_t i = 0; i < workerCount; i++)
         {
-            double advance = 0.0;
-            msdfgen::Shape shape;
-            FL_ASSERT(msdfgen::loadGlyph(shape, msdffontHandle, character, &advance), "Failed to load Glyph!");
+            s_WorkerPool->Submit([&]()
+                {
+                    // FreeType handles are not thread safe, so every worker loads its own copy of the font
+                    msdfgen::FreetypeHandle* workerFt = msdfgen::initializeFreetype();
+                    msdfgen::FontHandle* workerFontHandle = msdfgen::loadFont(workerFt, filePath.c_str());
+
+                    uint32_t glyphIndex;
+                    while ((glyphIndex = nextGlyphIndex++) < glyphBitmaps.size())
+                    {
+                        auto glyphStartTime = std::chrono::high_resolution_clock::now();
+                        bool isGenerated = GenerateGlyphBitmap(workerFontHandle, 32 + glyphIndex, border_width, glyphBitmaps[glyphIndex]);
+                        FL_ASSERT(isGenerated, "Failed to load Glyph!");
+                        glyphWorkDurationInNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - glyphStartTime).count();
+                    }
+
+                    msdfgen::destroyFont(workerFontHandle);
+                    msdfgen::deinitializeFreetype(workerFt);
+                }
+            );
+        }
+        s_WorkerPool->Wait();
 
-            shape.normalize();
+        // The summed up duration of all the glyphs is roughly what generating them on a single thread would take
+        float generationDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startTime).count() * 0.001f * 0.001f;
+        float glyphWorkDuration = glyphWorkDurationInNanoseconds * 0.001f * 0.001f;
+        FL_INFO("Generated {0} MSDF glyphs in {1} ms on {2} worker threads ({3} ms of glyph work, {4}x speedup)", glyphBitmaps.size(), generationDuration, workerCount, glyphWorkDuration, glyphWorkDuration / generationDuration);
 
-            auto bounds = shape.getBounds(border_width);
-            uint32_t glyphWidth = ceil(bounds.r - bounds.l);
-            uint32_t glyphHeight = ceil(bounds.t - bounds.b);
+        // Pack the tallest glyphs first, shelf packing works best in that order
+        std::sort(glyphBitmaps.begin(), glyphBitmaps.end(), [](const GlyphBitmap& a, const GlyphBitmap& b) { return a.Height > b.Height; });
 
-            msdfgen::edgeColoringSimple(shape, 3.0);
-            msdfgen::Bitmap<float, 3> msdf(glyphWidth, glyphHeight);
+        // The preloaded glyphs are packed into page 0 of the atlas, which is pinned so that they are never evicted
+        GlyphPageBuilder pinnedPage(GLYPH_ATLAS_PAGE_SIZE);
+        for (auto& glyphBitmap : glyphBitmaps)
+        {
+            bool isPacked = pinnedPage.AddGlyph(glyphBitmap.Width, glyphBitmap.Height, glyphBitmap.Pixels.data(), glyphBitmap.Metrics.uvMin, glyphBitmap.Metrics.uvMax);
+            FL_ASSERT(isPacked, "Failed to pack glyph {0} into the first page of the glyph atlas, GLYPH_ATLAS_PAGE_SIZE is too small!", glyphBitmap.Codepoint);
+            s_Characters[glyphBitmap.Codepoint] = glyphBitmap.Metrics;
+        }
 
-            msdfgen::generateMSDF(msdf, shape, s_FontProps.PixelRange, 1.0, msdfgen::Vector2(-bounds.l, -bounds.b));
+        s_GlyphAtlas = std::make_shared<GlyphAtlas>(GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_COUNT);
+        s_GlyphAtlas->UploadPage(0, pinnedPage.GetPixels().data());
+        for (auto& [codepoint, metrics] : s_Characters)
+        {
+            metrics.textureId = s_GlyphAtlas->GetTextureId();
+            metrics.atlasPage = 0;
+        }
+        UpdateAsciiCharacterTable();
 
-            uint32_t textureId;
-            glGenTextures(1, &textureId);
-            glBindTexture(GL_TEXTURE_2D, textureId);
+        FL_INFO("Packed {0} glyphs into the first {1}x{1} page of the glyph atlas", glyphBitmaps.size(), GLYPH_ATLAS_PAGE_SIZE);
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (!cacheFilePath.empty())
+        {
+            if (GlyphAtlasCache::Write(cacheFilePath, cacheKey, s_FontProps.AscenderY, s_FontProps.DescenderY, s_Characters, pinnedPage))
+                FL_INFO("Written glyph atlas cache to \"{0}\"", cacheFilePath);
+            else
+                FL_WARN("Failed to write glyph atlas cache to \"{0}\"", cacheFilePath);
+        }
 
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, msdf.width(), msdf.height(), 0, GL_RGB, GL_FLOAT, msdf.operator float* ());
+        // The font stays open for generating the glyphs of the other code points when they are first used
+        s_FreetypeHandle = ft;
+        s_FontHandle = msdffontHandle;
+    }
 
-            flame::character ch = {
-                textureId,
-                { msdf.width(), msdf.height() },
-                { shape.getBounds().l, shape.getBounds().t },
-                advance,
-            };
+    bool Renderer::LoadFontFromCache(const std::string& cacheFilePath, const GlyphAtlasCacheKey& cacheKey)
+    {
+        GlyphAtlasCache cache(cacheFilePath, cacheKey);
+        if (!cache.IsValid())
+        {
+            FL_INFO("Glyph atlas cache \"{0}\" is missing or out of date, generating the glyphs", cacheFilePath);
+            return false;
+        }
+
+        if (cache.GetAtlasWidth() != GLYPH_ATLAS_PAGE_SIZE || cache.GetAtlasHeight() != GLYPH_ATLAS_PAGE_SIZE)
+        {
+            FL_INFO("Glyph atlas cache \"{0}\" was generated with another page size, generating the glyphs", cacheFilePath);
+            return false;
+        }
+
+        s_FontProps.AscenderY = cache.GetAscenderY();
+        s_FontProps.DescenderY = cache.GetDescenderY();
+
+        // The pixels are uploaded straight from the mapped file into the pinned page, without any copy on the CPU side
+        s_GlyphAtlas = std::make_shared<GlyphAtlas>(GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_COUNT);
+        s_GlyphAtlas->UploadPage(0, cache.GetAtlasPixels());
 
-            s_Characters[character] = ch;
+        auto characters = cache.GetCharacters();
+        for (auto& [codepoint, character] : characters)
+        {
+            character.textureId = s_GlyphAtlas->GetTextureId();
+            character.atlasPage = 0;
+            s_Characters[codepoint] = character;
         }
-        msdfgen::destroyFont(msdffontHandle);
-        msdfgen::deinitializeFreetype(ft);
+
+        UpdateAsciiCharacterTable();
+
+        FL_INFO("Loaded {0} glyphs from the glyph atlas cache \"{1}\"", characters.size(), cacheFilePath);
+        return true;
     }
 
-    glm::vec2 Renderer::GetTextDimensions(const std::string& text, float scale)
+    void Renderer::UpdateAsciiCharacterTable()
     {
-        glm::vec2 textDimensions = { 0, 0 };
-        float lowestPositionOfChar = 0;
-        float highestPositionOfChar = 0;
-        for (std::string::const_iterator it = text.begin(); it != text.end(); it++)
+        for (uint32_t codepoint = 0; codepoint < s_AsciiCharacters.size(); codepoint++)
         {
-            textDimensions.x += s_Characters[*it].size.x * scale;
-            if (lowestPositionOfChar > -(s_Characters[*it].size.y - s_Characters[*it].bearing.y) * scale)
-                lowestPositionOfChar = -(s_Characters[*it].size.y - s_Characters[*it].bearing.y) * scale;
-            if (highestPositionOfChar < -(s_Characters[*it].size.y - s_Characters[*it].bearing.y) * scale + s_Characters[*it].size.y * scale)
-                highestPositionOfChar = -(s_Characters[*it].size.y - s_Characters[*it].bearing.y) * scale + s_Characters[*it].size.y * scale;
+            auto characterIt = s_Characters.find(codepoint);
+            s_AsciiCharacters[codepoint] = characterIt == s_Characters.end() ? nullptr : &characterIt->second;
         }
-        textDimensions.y = highestPositionOfChar - lowestPositionOfChar;
+    }
+
+    const flame::character* Renderer::GetCharacter(uint32_t codepoint)
+    {
+        if (codepoint < s_AsciiCharacters.size())
+            return s_AsciiCharacters[codepoint];
 
-        return textDimensions;
+        auto characterIt = s_Characters.find(codepoint);
+        if (characterIt != s_Characters.end())
+        {
+            s_GlyphAtlas->Touch(characterIt->second.atlasPage, s_FrameIndex);
+            return &characterIt->second;
+        }
+
+        if (!s_GlyphAtlas || s_MissingCodepoints.count(codepoint))
+            return nullptr;
+        return LoadCharacter(codepoint);
+    }
+
+    const flame::character* Renderer::LoadCharacter(uint32_t codepoint)
+    {
+        if (!s_FontHandle)
+        {
+            // The font isn't opened at all when the preloaded glyphs come from the cache, so it is opened on the first glyph that isn't cached
+            s_FreetypeHandle = msdfgen::initializeFreetype();
+            s_FontHandle = s_FreetypeHandle ? msdfgen::loadFont(s_FreetypeHandle, s_UserFontFilePath.c_str()) : nullptr;
+            if (!s_FontHandle)
+            {
+                FL_WARN("Failed to load font from the file path: {0}, only the preloaded glyphs will be rendered", s_UserFontFilePath);
+                s_MissingCodepoints.insert(codepoint);
+                return nullptr;
+            }
+        }
+
+        GlyphBitmap glyphBitmap;
+        if (!GenerateGlyphBitmap(s_FontHandle, codepoint, s_FontProps.BorderWidth, glyphBitmap))
+        {
+            s_MissingCodepoints.insert(codepoint);
+            return nullptr;
+        }
+
+        flame::character& metrics = glyphBitmap.Metrics;
+        if (!s_GlyphAtlas->AddGlyph(glyphBitmap.Width, glyphBitmap.Height, glyphBitmap.Pixels.data(), metrics.atlasPage, metrics.uvMin, metrics.uvMax))
+        {
+            // Glyphs can be loaded outside of Begin() and End(), e.g. by GetTextDimensions(), so nothing is drawn here.
+            // Instead the pages used in this frame are kept, as the glyphs queued in the text batch may still sample them
+            int32_t evictedPage = s_GlyphAtlas->EvictLeastRecentlyUsedPage(s_FrameIndex);
+            // Every page is used in this frame, so the glyph is tried again in the next one
+            if (evictedPage == -1)
+                return nullptr;
+
+            uint32_t evictedGlyphCount = 0;
+            for (auto it = s_Characters.begin(); it != s_Characters.end();)
+            {
+                if (it->second.atlasPage == (uint32_t)evictedPage)
+                {
+                    it = s_Characters.erase(it);
+                    evictedGlyphCount++;
+                }
+                else
+                    it++;
+            }
+            FL_INFO("Evicted {0} glyphs from glyph atlas page {1}", evictedGlyphCount, evictedPage);
+
+            if (!s_GlyphAtlas->AddGlyph(glyphBitmap.Width, glyphBitmap.Height, glyphBitmap.Pixels.data(), metrics.atlasPage, metrics.uvMin, metrics.uvMax))
+            {
+                FL_WARN("Glyph U+{0} doesn't fit into the glyph atlas", codepoint);
+                s_MissingCodepoints.insert(codepoint);
+                return nullptr;
+            }
+        }
+
+        metrics.textureId = s_GlyphAtlas->GetTextureId();
+        s_GlyphAtlas->Touch(metrics.atlasPage, s_FrameIndex);
+        return &(s_Characters[codepoint] = metrics);
+    }
+
+    bool Renderer::GenerateGlyphBitmap(msdfgen::FontHandle* fontHandle, uint32_t codepoint, double borderWidth, GlyphBitmap& glyphBitmap)
+    {
+        double advance = 0.0;
+        msdfgen::Shape shape;
+        if (!msdfgen::loadGlyph(shape, fontHandle, codepoint, &advance))
+            return false;
+
+        shape.normalize();
+
+        auto bounds = shape.getBounds(borderWidth);
+        uint32_t glyphWidth = ceil(bounds.r - bounds.l);
+        uint32_t glyphHeight = ceil(bounds.t - bounds.b);
+
+        msdfgen::edgeColoringSimple(shape, 3.0);
+        msdfgen::Bitmap<float, 3> msdf(glyphWidth, glyphHeight);
+
+        msdfgen::generateMSDF(msdf, shape, s_FontProps.PixelRange, 1.0, msdfgen::Vector2(-bounds.l, -bounds.b));
+
+        glyphBitmap.Codepoint = codepoint;
+        glyphBitmap.Width = msdf.width();
+        glyphBitmap.Height = msdf.height();
+        glyphBitmap.Pixels.resize(3 * (size_t)glyphBitmap.Width * glyphBitmap.Height);
+
+        const float* msdfPixels = msdf;
+        for (size_t i = 0; i < glyphBitmap.Pixels.size(); i++)
+            glyphBitmap.Pixels[i] = msdfgen::pixelFloatToByte(msdfPixels[i]);
+
+        glyphBitmap.Metrics = {
+            0,
+            { msdf.width(), msdf.height() },
+            { shape.getBounds().l, shape.getBounds().t },
+            advance,
+        };
+        return true;
+    }
+
+    glm::vec2 Renderer::GetTextDimensions(const std::string& text, float scale, float maxWidth)
+    {
+        if (!s_TextLayoutCache)
+            return { 0.0f, 0.0f };
+        return s_TextLayoutCache->GetLayout(text, scale, maxWidth)->dimensions;
+    }
+
+    std::shared_ptr<const TextLayout> Renderer::GetTextLayout(const std::string& text, float scale, float maxWidth)
+    {
+        FL_ASSERT(s_TextLayoutCache, "Font rendering is disabled, text can't be laid out!");
+        return s_TextLayoutCache->GetLayout(text, scale, maxWidth);
     }
 
     glm::vec2 Renderer::ConvertPixelsToOpenGLValues(const glm::vec2& value_in_pixels)
@@ -565,61 +1642,18 @@ namespace FlameUI {
         return static_cast<float>(Y) * (2.0f / s_ViewportSize.y) * s_WindowContentScale.y;
     }
 
-    uint32_t Renderer::CreateTexture(const std::string& filePath)
+    TextureLocation Renderer::CreateTexture(const std::string& filePath)
     {
-        // stbi_set_flip_vertically_on_load(true);
-
-        // int width, height, channels;
-        // unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &channels, 0);
-
-        // FL_ASSERT(data, "Failed to load texture from \"{0}\"", filePath);
-
-        // GLenum internalFormat = 0, dataFormat = 0;
-        // if (channels == 4)
-        // {
-        //     internalFormat = GL_RGBA8;
-        //     dataFormat = GL_RGBA;
-        // }
-        // else if (channels == 3)
-        // {
-        //     internalFormat = GL_RGB8;
-        //     dataFormat = GL_RGB;
-        // }
-
-        // uint32_t textureId;
-        // glGenTextures(1, &textureId);
-        // glBindTexture(GL_TEXTURE_2D, textureId);
-
-        // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-        // glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-        // glGenerateMipmap(GL_TEXTURE_2D);
-
-        // stbi_image_free(data);
-
-        uint32_t* data = new uint32_t[100 * 100];
-        for (uint32_t i = 0; i < 100 * 100; i++)
-            data[i] = 0xffff00ff;
-
-        uint32_t textureId;
-        GL_CHECK_ERROR(glGenTextures(1, &textureId));
-        glActiveTexture(GL_TEXTURE0);
-        GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, textureId));
-
-        // Set parameters to determine how the texture is resized
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // Set parameters to determine how the texture wraps at edges
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        DecodedImage image;
+        if (!DecodeImage(filePath, image))
+            return TextureLocation{};
+        return s_TextureArrayPool->Add(image.Width, image.Height, image.Pixels.get());
+    }
 
-        // glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        GL_CHECK_ERROR(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 100, 100, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, data));
-        glGenerateMipmap(GL_TEXTURE_2D);
-        return textureId;
+    void Renderer::DestroyTexture(const TextureLocation& texture)
+    {
+        if (texture.ArrayTextureId)
+            s_TextureArrayPool->Remove(texture);
     }
 
     std::tuple<std::string, std::string> Renderer::ReadShaderSource(const std::string& filePath)
@@ -651,32 +1685,65 @@ namespace FlameUI {
         return std::make_tuple(ss[0].str(), ss[1].str());
     }
 
-    GLint Renderer::GetUniformLocation(const std::string& name, uint32_t shaderId)
+    GLint Renderer::GetUniformLocation(HashedId name, uint32_t shaderId)
     {
-        if (s_UniformLocationCache.find(name) != s_UniformLocationCache.end())
-            return s_UniformLocationCache[name];
+        auto tableIt = s_UniformLocationTables.find(shaderId);
+        FL_ASSERT(tableIt != s_UniformLocationTables.end(), "Shader program {0} wasn't created by Renderer::CreateShaderProgram()!", shaderId);
+        UniformLocationTable& table = tableIt->second;
 
-        GLint location = glGetUniformLocation(shaderId, name.c_str());
+        uint32_t slot = (uint32_t)(name.Hash & (UNIFORM_LOCATION_TABLE_SIZE - 1));
+        while (table.Entries[slot].NameHash && (table.Entries[slot].NameHash != name.Hash || table.Entries[slot].Name != name.Name))
+            slot = (slot + 1) & (UNIFORM_LOCATION_TABLE_SIZE - 1);
+
+        auto& entry = table.Entries[slot];
+        if (entry.NameHash)
+            return entry.Location;
+
+        // Keep a slot free so that the probing of a name which isn't in the table always ends
+        FL_ASSERT(table.Count + 1 < UNIFORM_LOCATION_TABLE_SIZE, "Uniform location table of shader program {0} is full, increase UNIFORM_LOCATION_TABLE_SIZE!", shaderId);
+        GLint location = glGetUniformLocation(shaderId, name.Name);
         if (location == -1)
-            FL_WARN("Uniform \"{0}\" not found!", name);
-        s_UniformLocationCache[name] = location;
+            FL_WARN("Uniform \"{0}\" not found!", name.Name);
+        entry.NameHash = name.Hash;
+        entry.Name = name.Name;
+        entry.Location = location;
+        table.Count++;
         return location;
     }
 
-    uint32_t Renderer::GetTextureIdIfAvailable(const char* textureFilePath)
-    {
-        if (s_TextureIdCache.find(textureFilePath) != s_TextureIdCache.end())
-            return s_TextureIdCache[textureFilePath];
-        else
-            return 0;
-    }
-
     void Renderer::CleanUp()
     {
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glUseProgram(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindVertexArray(0);
+        GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GLState::UseProgram(0);
+        GLState::BindTexture(0, GL_TEXTURE_2D, 0);
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+        GLState::BindVertexArray(0);
+
+        if (s_FontHandle)
+            msdfgen::destroyFont(s_FontHandle);
+        if (s_FreetypeHandle)
+            msdfgen::deinitializeFreetype(s_FreetypeHandle);
+        s_FontHandle = nullptr;
+        s_FreetypeHandle = nullptr;
+
+        // The atlas texture and the instance buffers have to be deleted while the OpenGL context is still alive
+        s_TextLayoutCache.reset();
+        s_GlyphAtlas.reset();
+        s_TextureCache.reset();
+        s_TextureArrayPool.reset();
+        s_Batch.InstanceRing.reset();
+        glDeleteBuffers(1, &s_RetainedBatch.InstanceBufferId);
+        glDeleteVertexArrays(1, &s_RetainedBatch.VertexArrayId);
+        s_RetainedBatch = RetainedBatch();
+        glDeleteProgram(s_Batch.ShaderProgramId);
+        for (uint32_t programId : s_Batch.VariantShaderProgramIds)
+            glDeleteProgram(programId);
+        glDeleteProgram(s_TextBatch.ShaderProgramId);
+        s_Batch.ShaderProgramId = s_TextBatch.ShaderProgramId = 0;
+        s_Batch.VariantShaderProgramIds.fill(0);
+        s_UniformLocationTables.clear();
+        s_TextBatch.InstanceRing.reset();
+        s_WorkerPool.reset();
     }
 }
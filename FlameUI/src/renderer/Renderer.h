@@ -1,20 +1,51 @@
 #pragma once
 #include <array>
+#include <memory>
 #include <vector>
 #include <string>
 #include <glad/glad.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <GLFW/glfw3.h>
 #include "core/Core.h"
 #include "ui/Text.h"
+#include "ui/TextLayout.h"
 #include "core/ElementTypeIndex.h"
+#include "core/StyleIndex.h"
+#include "renderer/Framebuffer.h"
+#include "renderer/GlyphAtlas.h"
+#include "renderer/GlyphAtlasCache.h"
+#include "renderer/InstanceRingBuffer.h"
+#include "renderer/TextureArrayPool.h"
+#include "renderer/TextureCache.h"
+#include "utils/ThreadPool.h"
+#include "utils/Hash.h"
 
-/// This Macro contains the max number of texture slots that the GPU supports, varies for each computer.
+namespace msdfgen { class FreetypeHandle; class FontHandle; }
+
+/// Number of texture slots of the quad shader, the batch uses fewer of them if GL_MAX_TEXTURE_IMAGE_UNITS is lower on the GPU
 #define MAX_TEXTURE_SLOTS 16
-#define MAX_QUADS 1000
-#define MAX_VERTICES 4 * MAX_QUADS
-#define MAX_INDICES 6 * MAX_QUADS
+/// Number of quads a batch can hold initially, the batch grows from here based on the peak number of quads seen in a frame
+#define INITIAL_BATCH_QUADS 1000
+/// Upper limit for the capacity of a batch, frames with more quads than this are split into multiple draw calls
+#define MAX_BATCH_QUADS 65536
+/// Number of glyphs the text batch can hold, text beyond this is split into multiple draw calls
+#define MAX_TEXT_BATCH_GLYPHS 16384
+/// Width and height of every page of the glyph atlas, in pixels
+#define GLYPH_ATLAS_PAGE_SIZE 1024
+/// Number of glyph atlas pages, page 0 is pinned to the preloaded ASCII glyphs and the rest are filled on demand and evicted in LRU order
+#define GLYPH_ATLAS_PAGE_COUNT 4
 #define TITLE_BAR_HEIGHT 15
+/// Number of slots of the uniform location table of every shader program, has to be a power of 2 and larger than the number of uniforms of a program
+#define UNIFORM_LOCATION_TABLE_SIZE 32
+/// Half the extent of the clip rectangle of quads which aren't clipped, in pixels, the clip rectangles of the quads are stored as 16 bit integers
+#define FL_UNCLIPPED_EXTENT INT16_MAX
+/// Pixels added around every signed distance field primitive, so that its antialiased edge isn't cut off by the quad, has to match c_ShapePadding in Quad.glsl
+#define FL_SHAPE_AA_PADDING 1.0f
+/// Steps per pixel of the fixed point `shape_param` of the quad instances, has to match c_ShapeParamScale in Quad.glsl
+#define FL_SHAPE_PARAM_SCALE 16.0f
+/// Id which doesn't refer to any retained range, see `Renderer::CreateRetainedRange()`
+#define FL_INVALID_RETAINED_RANGE UINT32_MAX
 
 namespace FlameUI {
     enum class UnitType
@@ -22,6 +53,21 @@ namespace FlameUI {
         NONE = 0, PIXEL_UNITS, OPENGL_UNITS
     };
 
+    /// How the quad shader handles the different element types, which one is faster depends on the GPU
+    enum class QuadShaderStrategy
+    {
+        /// A single program which switches on the element type of every fragment, all the quads of a batch are drawn using one call
+        UBER_SHADER = 0,
+        /// A program specialized for every element type, the quads are drawn using one call per run of quads of the same element type
+        SPECIALIZED_VARIANTS
+    };
+
+    /// Fragments drawn by the quad shader, which has to match u_AlphaPass in Quad.glsl
+    enum class QuadAlphaPass
+    {
+        ALL_FRAGMENTS = 0, OPAQUE_FRAGMENTS, TRANSLUCENT_FRAGMENTS
+    };
+
     struct ThemeInfo
     {
         glm::vec4 panelBgColor;
@@ -30,6 +76,19 @@ namespace FlameUI {
         glm::vec4 borderColor;
         glm::vec4 buttonColor;
         glm::vec4 buttonHoveredColor;
+        /// Has a default, so that themes written before the pressed style existed still draw pressed buttons in a visible color
+        glm::vec4 buttonPressedColor{ 0.06f, 0.53f, 0.98f, 1.0f };
+        /// Color behind all the panels, used to clear the damaged regions when partial redraw is enabled
+        glm::vec4 windowBgColor;
+        /// Width of the panel border in pixels
+        float     panelBorderWidth{ 1.0f };
+        /// Radius of the corners of the panels in pixels, panels with rounded corners aren't used as occluders
+        float     panelCornerRadius{ 0.0f };
+        /// Standard deviation of the gaussian blur of the panel drop shadows in pixels, 0 disables the shadows and is the default
+        float     panelShadowBlurSigma{ 0.0f };
+        /// Offset of the panel drop shadows from their panels in pixels
+        glm::vec2 panelShadowOffset{ 0.0f, -4.0f };
+        glm::vec4 panelShadowColor{ 0.0f, 0.0f, 0.0f, 0.5f };
     };
 
     struct RendererInitInfo
@@ -37,47 +96,105 @@ namespace FlameUI {
         GLFWwindow* userWindow;
         bool enableFontRendering{ true };
         std::string fontFilePath{ FL_PROJECT_DIR"FlameUI/resources/fonts/OpenSans-Regular.ttf" };
+        /// Directory where the generated glyph atlas of the font is cached between runs, an empty string disables the cache
+        std::string fontCacheDirectory{ FL_PROJECT_DIR"FlameUI/cache/" };
+        /// Draws into a persistent back buffer and redraws only the regions damaged by changed widgets, the back buffer is copied to the window every frame
+        bool enablePartialRedraw{ false };
+        /// Fraction of the viewport area, damage covering more than this redraws the whole viewport instead
+        float fullRedrawDamageThreshold{ 0.5f };
+        /// Bytes of texture arrays that the textures of textured quads can take up, the textures of the least recently used arrays are evicted beyond it
+        uint64_t textureMemoryBudget{ 256ull * 1024 * 1024 };
+        QuadShaderStrategy quadShaderStrategy{ QuadShaderStrategy::UBER_SHADER };
         ThemeInfo* themeInfo;
     };
 
 
-    // The [Vertex] struct represents an OpenGL Vertex.
-    struct Vertex
+    /// The [QuadInstance] struct is the packed 48 byte per-instance record of a quad, the vertex shader expands it into the 4 corners of the quad.
+    /// `GenerateQuadInstances()` in QuadKernels.cpp depends on its layout, which is checked there by static asserts
+    struct QuadInstance
     {
-        /// Position from -1.0f to 1.0f on both x-axis and y-axis
+        /// Position of the center of the quad in pixels, relative to the center of the viewport
         glm::vec3 position;
-        /// Color in rgba format, each channel ranging from 0.0f to 1.0f
-        glm::vec4 color;
-        /// Texture coordinates ranging from 0.0f to 1.0f
-        glm::vec2 texture_uv;
-        /// Texture index which will be used as opengl texture slot to which the texture will be bound
+        /// Quad Dimensions in pixels, used to expand the corners and by the shader to customize the quad
+        glm::vec2 dimensions;
+        /// Color in packed RGBA8 format, unpacked to 0.0f to 1.0f channels by the vertex attribute
+        uint32_t  color;
+        /// Texture slot to which the texture array of the texture is bound, -1.0f for untextured quads
         float     texture_index;
-        /// Quad Dimensions which will be used by the shader to customize the quad
-        glm::vec2 quad_dimensions;
         /// This will tell the shader what kind of UI Element is being rendered
-        float     element_type_index;
+        uint8_t   element_type_index;
         /// This will be used by the shader to determine the title bar color of the panel
-        float     is_panel_active;
+        uint8_t   is_panel_active;
+        /// Index into the style colors of the theme, `FL_STYLE_NONE_INDEX` makes the shader use `color` instead
+        uint16_t  style_index;
+        /// Clip rectangle in pixels in the l, r, b, t order of `Rect2D`, the vertex shader clamps the corners of the quad to it.
+        /// Being per instance, quads with different clip rectangles are still drawn in a single call
+        int16_t   clip_rect[4];
+        /// Layer of the texture array that the texture is stored in, see `TextureLocation`
+        uint16_t  texture_layer;
+        /// `TextureLocation::UVScale` as 16 bit normalized values
+        uint16_t  texture_uv_scale[2];
+        /// Size parameter of the signed distance field primitives in 1/`FL_SHAPE_PARAM_SCALE` pixels: the corner radius of rounded rects and the thickness of rings, lines and capsules.
+        /// Negative for lines and capsules going down from left to right, which otherwise can't be told apart from the ones going up by their bounding quad
+        int16_t   shape_param;
 
         /// Default Constructor
-        Vertex()
-            : position(0.0f), color(1.0f), texture_uv(0.0f), texture_index(-1.0f), quad_dimensions(0.0f), element_type_index(FL_ELEMENT_TYPE_GENERAL_INDEX)
+        QuadInstance()
+            : position(0.0f), dimensions(0.0f), color(0xffffffff), texture_index(-1.0f), element_type_index((uint8_t)FL_ELEMENT_TYPE_GENERAL_INDEX), is_panel_active(0), style_index(FL_STYLE_NONE_INDEX),
+            clip_rect{ -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT, -FL_UNCLIPPED_EXTENT, FL_UNCLIPPED_EXTENT }, texture_layer(0), texture_uv_scale{ 0, 0 }, shape_param(0)
         {
         }
     };
 
+    /// Quads in structure-of-arrays form for `Renderer::AddQuads()`, every array holds `count` elements
+    struct QuadSpans
+    {
+        /// Positions of the centers of the quads
+        const glm::vec3* positions;
+        const glm::vec2* dimensions;
+        const glm::vec4* colors;
+        /// Element type of each quad, `nullptr` draws all of them as `FL_ELEMENT_TYPE_GENERAL_INDEX`
+        const uint8_t*   elementTypeIndices = nullptr;
+        size_t           count;
+    };
+
+    /// The [GlyphInstance] struct is the per-instance record of a glyph quad, expanded into its corners by the Font.glsl vertex shader
+    struct GlyphInstance
+    {
+        /// Position of the bottom left corner of the glyph quad in pixels, relative to the center of the viewport
+        glm::vec3 position;
+        /// Dimensions of the glyph quad in pixels
+        glm::vec2 dimensions;
+        /// Texture coordinates of the glyph in the atlas, bottom left corner in xy and top right corner in zw
+        glm::vec4 texture_uv_rect;
+        /// Color in packed RGBA8 format
+        uint32_t  color;
+        /// Page of the glyph atlas that the glyph is sampled from
+        float     atlas_page;
+        /// Clip rectangle in pixels in the l, r, b, t order of `Rect2D`, the vertex shader clamps the corners of the glyph quad to it like for `QuadInstance`
+        int16_t   clip_rect[4];
+    };
+
     class Renderer
     {
     public:
         // The Init function should be called after the GLFW window creation and before the main loop
         static void        Init(const RendererInitInfo& rendererInitInfo);
         static void        OnResize();
-        static ThemeInfo   GetThemeInfo() { return s_ThemeInfo; }
+        static const ThemeInfo& GetThemeInfo() { return s_ThemeInfo; }
+        /// Replaces the theme, which is uploaded to the GPU at the beginning of the next frame
+        static void        SetThemeInfo(const ThemeInfo& themeInfo);
+        /// Changes whenever the theme is replaced, so that state derived from the theme can tell that it is out of date
+        static uint32_t    GetThemeRevision() { return s_ThemeRevision; }
         static glm::vec2   GetWindowContentScale() { return s_WindowContentScale; }
         static GLFWwindow* GetUserGLFWwindow();
         static glm::vec2   GetViewportSize();
-        static glm::vec2   GetTextDimensions(const std::string& text, float scale);
-        static GLint       GetUniformLocation(const std::string& name, uint32_t shaderId);
+        /// Returns the dimensions of the laid out text in pixels, a `maxWidth` of 0 disables wrapping
+        static glm::vec2   GetTextDimensions(const std::string& text, float scale, float maxWidth = 0.0f);
+        /// Returns the cached layout of the text, which can be drawn again and again using `AddText()` without laying it out again
+        static std::shared_ptr<const TextLayout> GetTextLayout(const std::string& text, float scale, float maxWidth = 0.0f);
+        /// Returns the location of the uniform in the shader program, querying OpenGL only the first time the uniform is looked up in that program
+        static GLint       GetUniformLocation(HashedId name, uint32_t shaderId);
         static float       GetAspectRatio() { return s_AspectRatio; }
         static glm::vec2   ConvertPixelsToOpenGLValues(const glm::vec2& value_in_pixels);
         static glm::vec2   ConvertOpenGLValuesToPixels(const glm::vec2& opengl_coords);
@@ -85,8 +202,62 @@ namespace FlameUI {
         static float       ConvertYAxisPixelValueToOpenGLValue(int Y);
         static void        AddQuad(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, const char* textureFilePath, UnitType unitType = UnitType::PIXEL_UNITS, bool isPanelActive = false);
         static void        AddQuad(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, UnitType unitType = UnitType::PIXEL_UNITS, bool isPanelActive = false);
-        static void        AddText(const std::string& text, const glm::vec2& position_in_pixels, float scale, const glm::vec4& color);
-        static uint32_t    CreateTexture(const std::string& filePath);
+        /// Adds many untextured quads at once, e.g. the bars of a chart, which are written straight into the batch by a SIMD kernel
+        static void        AddQuads(const QuadSpans& quads, UnitType unitType = UnitType::PIXEL_UNITS);
+        /// Adds a quad which takes its color from the theme, the color is resolved by the shader using the `styleIndex`
+        static void        AddStyledQuad(const glm::vec3& position, const glm::vec2& dimensions, uint16_t styleIndex, const float elementTypeIndex, UnitType unitType = UnitType::PIXEL_UNITS, bool isPanelActive = false);
+        /// Adds the drop shadow of a panel with the given center and dimensions, shaded in a single pass by the quad shader as a blurred rounded box.
+        /// The shadow is placed and blurred as set in the theme, its depth is `panelPosition.z`
+        static void        AddPanelShadow(const glm::vec3& panelPosition, const glm::vec2& panelDimensions);
+        /// Returns the rectangle covered by a panel together with its drop shadow
+        static Rect2D      GetPanelShadowBounds(const Rect2D& panel_rect_in_pixels);
+        /// Signed distance field primitives in pixel units, which are drawn by the quad shader in the same batch as the quads and antialiased over one physical pixel at any scale
+        static void        AddCircle(const glm::vec3& center, float radius, const glm::vec4& color);
+        /// Adds a circle outline, the `thickness` goes inwards from the `radius`
+        static void        AddRing(const glm::vec3& center, float radius, float thickness, const glm::vec4& color);
+        static void        AddRoundedRect(const glm::vec3& position, const glm::vec2& dimensions, float cornerRadius, const glm::vec4& color);
+        /// Adds a line with flat ends at the depth `z`
+        static void        AddLine(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color);
+        /// Adds a line with round ends at the depth `z`
+        static void        AddCapsule(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color);
+        static void        AddText(const std::string& text, const glm::vec3& position_in_pixels, float scale, const glm::vec4& color, float maxWidth = 0.0f);
+        static void        AddText(const TextLayout& layout, const glm::vec3& position_in_pixels, const glm::vec4& color);
+        /// Decodes the image file and loads it into the texture array pool right away, returns an empty location if the file can't be loaded.
+        /// Textured quads don't wait for this, they stream their textures in the background and draw a placeholder until the texture is resident
+        static TextureLocation CreateTexture(const std::string& filePath);
+        /// Frees a texture created by `CreateTexture()`, the textures of textured quads are freed by the texture cache instead
+        static void        DestroyTexture(const TextureLocation& texture);
+        static const TextureCacheStats& GetTextureCacheStats() { return s_TextureCache->GetStats(); }
+
+        /// Creates an empty range of quads which stays resident on the GPU and is drawn every frame, until it is recorded again
+        static uint32_t    CreateRetainedRange();
+        /// Every quad added until `EndRetainedRange()` replaces the contents of the range, instead of going into the batch of the current frame.
+        /// Only untextured quads can be retained
+        static void        BeginRetainedRange(uint32_t rangeId);
+        /// Uploads the recorded quads of the range, only the instances of this range are sent to the GPU
+        static void        EndRetainedRange();
+        /// Returns false if the contents of the range are out of date and have to be recorded again, e.g. before it was recorded for the first time
+        static bool        IsRetainedRangeValid(uint32_t rangeId);
+        /// Frees the slots of the range, which turn into degenerate quads until the retained batch is compacted, and makes the id available again
+        static void        DestroyRetainedRange(uint32_t rangeId);
+        /// Marks a region in pixel units as changed, so that it is redrawn when partial redraw is enabled.
+        /// Everything drawn outside of the damaged regions keeps the pixels of the previous frames
+        static void        AddDamageRect(const Rect2D& rect_in_pixels);
+        /// Restricts the quads added until the matching `PopClipRect()` to the intersection of a rectangle in pixel units and the current clip rectangle.
+        /// Quads entirely outside of it are rejected, quads which are partially inside are clipped to it by the vertex shader.
+        /// Every quad is rejected while the intersection is empty
+        static void        PushClipRect(const Rect2D& rect_in_pixels);
+        static void        PopClipRect();
+        /// Returns false if a rectangle in pixel units is entirely outside of the current clip rectangle or the viewport, so that its quads can be skipped.
+        /// Only the clip rectangle is tested while a retained range is recorded, as the retained quads stay valid when the viewport changes
+        static bool        IsRect2DVisible(const Rect2D& rect_in_pixels);
+        /// Number of quads and glyphs rejected by `IsRect2DVisible()` since the beginning of the frame
+        static uint32_t    GetRejectedQuadCount() { return s_RejectedQuadCount; }
+        /// Switches between the uber shader and its specialized variants, all of which are compiled by `Init()`, so that they can be compared at runtime
+        static void        SetQuadShaderStrategy(QuadShaderStrategy strategy) { s_Batch.ShaderStrategy = strategy; }
+        static QuadShaderStrategy GetQuadShaderStrategy() { return s_Batch.ShaderStrategy; }
+        /// Number of draw calls of quads, retained ones included, issued since the beginning of the frame
+        static uint32_t    GetQuadDrawCallCount() { return s_QuadDrawCallCount; }
         static void        CleanUp();
 
         static void Begin();
@@ -98,15 +269,112 @@ namespace FlameUI {
         /// Batch Handling functions
         static void InitBatch();
         static void FlushBatch();
+        /// Sorts the instances of the quad batch back to front by their sort keys, returns the instances in the order they are drawn
+        static const QuadInstance* SortBatchInstances();
+        static void InitTextBatch();
+        static void FlushTextBatch();
+        /// Reallocates the GPU buffers of the batch so that they can hold `quadCapacity` quads
+        static void ResizeBatch(uint32_t quadCapacity);
+        /// Tests a quad given by its center and dimensions in `unitType` units using `IsRect2DVisible()`, counting it if it is rejected
+        static bool IsQuadVisible(const glm::vec3& position, const glm::vec2& dimensions, UnitType unitType);
+        /// Removes the instances rejected by `IsRect2DVisible()` keeping the order of the rest, returns the number of instances kept
+        static size_t RemoveInvisibleInstances(QuadInstance* instances, size_t instanceCount);
+        /// Updates `s_PackedClipRect` from the top of the clip rectangle stack
+        static void PackClipRect();
+        /// Makes room for one more quad in the batch, flushing it first if it is full
+        static void PrepareBatchForQuad();
+        /// Converts the quad to a `QuadInstance` and appends it to the batch
+        static void AddQuadInstance(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, float textureIndex, UnitType unitType, bool isPanelActive, uint16_t styleIndex = FL_STYLE_NONE_INDEX, const TextureLocation* texture = nullptr, int16_t shapeParam = 0);
+        /// Adds the quad of a signed distance field primitive, padded for its antialiased edge, `shapeParam` is in pixels
+        static void AddShape(const glm::vec3& position, const glm::vec2& dimensions, const glm::vec4& color, const float elementTypeIndex, float shapeParam, bool isDescending = false);
+        static void AddSegment(const glm::vec2& start, const glm::vec2& end, float z, float thickness, const glm::vec4& color, const float elementTypeIndex);
+        /// Uploads the theme colors to the theme uniform buffer, only called when the theme changes
+        static void UploadTheme();
+        /// Sets up the per-instance vertex attributes of `QuadInstance` for the currently bound vertex array and instance buffer,
+        /// starting at the instance `firstInstance` of the buffer
+        static void SetupQuadInstanceAttributes(uint32_t firstInstance = 0);
+        /// Sets the texture samplers and the uniform block bindings of a program compiled from Quad.glsl
+        static void SetupQuadShaderProgram(uint32_t programId);
+        /// Draws the quads `firstInstance` to `firstInstance + instanceCount` of the instance buffer of the bound vertex array using the current shader strategy.
+        /// `instances` are the same quads on the CPU, which the specialized variants split into runs of the same element type
+        static void DrawQuadInstances(const QuadInstance* instances, uint32_t firstInstance, uint32_t instanceCount, uint32_t instanceBufferId);
+        /// Makes the quad programs of the current shader strategy draw only the fragments of the pass
+        static void SetQuadAlphaPass(QuadAlphaPass alphaPass);
+        static void InitRetainedBatch();
+        /// The opaque fragments are drawn with depth writes, before the quads of the frame.
+        /// The translucent fragments are drawn after the quads and the text of the frame without writing depth, which relies on the ranges being laid out from back to front
+        static void DrawRetainedBatch(QuadAlphaPass alphaPass);
+        /// Lays out the ranges from back to front by the depth of their first quad, which is the back most quad of a panel, if any range changed since the last call.
+        /// Ranges already in order are left alone, otherwise the ranges are packed together in order and the whole buffer is uploaded again
+        static void OrderRetainedRanges();
+        /// Makes sure that the GPU buffer of the retained batch can hold all the allocated instances, compacting the ranges first if most of the buffer is unused.
+        /// Returns true if the whole buffer was uploaded again
+        static bool ReserveRetainedInstances();
+        static void UploadRetainedInstances(uint32_t firstInstance, uint32_t instanceCount);
+        /// Marks everything that depends on the size of the viewport in framebuffer pixels as out of date
+        static void InvalidateViewportDependentState();
+        /// Binds the back buffer and restricts drawing to the damaged region, called before the first draw of a frame.
+        /// A draw before `End()` can't know the damage of the whole frame yet, so it makes the frame a full redraw
+        static void PrepareFrameForDrawing(bool isEndOfFrame);
+        /// Copies the back buffer to the window
+        static void FinishFrameDrawing();
+        /// Packs a color with channels ranging from 0.0f to 1.0f into RGBA8 format
+        static uint32_t PackColor(const glm::vec4& color);
 
         /// Private Functions which will be used by the Renderer as Utilites
         static void     OnUpdate();
         static void     LoadFont(const std::string& filePath);
-        static uint32_t GetTextureIdIfAvailable(const char* textureFilePath);
+        /// Compiles the shader file, `defines` are inserted into both stages right after their #version line
+        static uint32_t CreateShaderProgram(const std::string& filePath, const std::string& defines = "");
+        /// Loads the glyph atlas and the glyph metrics from the cache file, returns false if the cache is missing or out of date
+        static bool     LoadFontFromCache(const std::string& cacheFilePath, const GlyphAtlasCacheKey& cacheKey);
+        /// Fills the ASCII lookup table from `s_Characters`, has to be called once the preloaded glyphs are loaded
+        static void     UpdateAsciiCharacterTable();
+        /// Returns the glyph of the code point, generating it first if it is seen for the first time, nullptr if the font has no such glyph
+        static const flame::character* GetCharacter(uint32_t codepoint);
+        /// Generates the glyph of a code point outside of the preloaded range and packs it into the glyph atlas, evicting a page if the atlas is full
+        static const flame::character* LoadCharacter(uint32_t codepoint);
+        /// Returns the texture slot of the batch that the texture array is bound to, adding it to the batch first, which flushes the batch if every slot is taken
+        static float    GetBatchTextureSlot(uint32_t arrayTextureId);
+
     private:
         /// Struct that contains all the matrices needed by the shader, which will be stored in a Uniform Buffer
+        /// The projection maps pixels relative to the center of the viewport to clip space
         struct UniformBufferData { glm::mat4 ProjectionMatrix; };
+        /// Open addressing table of the uniform locations of one shader program, keyed by the hash of the uniform name.
+        /// Slots are probed linearly from the hash, so a lookup is a single probe unless two names land on the same slot.
+        /// The name is compared as well, so that two names with the same hash get separate slots
+        struct UniformLocationTable
+        {
+            struct Entry
+            {
+                /// Hash of the uniform name, 0 for empty slots
+                uint64_t    NameHash = 0;
+                std::string Name;
+                GLint       Location = -1;
+            };
+            std::array<Entry, UNIFORM_LOCATION_TABLE_SIZE> Entries{};
+            uint32_t                                       Count = 0;
+        };
         struct TextureUniformBufferData { int Samplers[MAX_TEXTURE_SLOTS]; };
+        /// Contents of the Theme uniform block in std140 layout, bound to binding point 1
+        struct ThemeUniformBufferData
+        {
+            glm::vec4 PanelBgColor;
+            glm::vec4 PanelTitleBarActiveColor;
+            glm::vec4 PanelTitleBarInactiveColor;
+            glm::vec4 BorderColor;
+            /// Colors of the quads by their style index
+            glm::vec4 StyleColors[FL_STYLE_COUNT];
+            /// Height of the panel title bar in pixels
+            float     TitleBarHeight;
+            float     PanelBorderWidth;
+            float     PanelCornerRadius;
+            float     PanelShadowBlurSigma;
+            glm::vec4 PanelShadowColor;
+            glm::vec2 PanelShadowOffset;
+            float     Padding[2];
+        };
         struct FontProps
         {
             float Scale;
@@ -114,15 +382,105 @@ namespace FlameUI {
             float PixelRange;
             float AscenderY;
             float DescenderY;
+            float BorderWidth;
+            /// Hash of the font file contents, identifies the font in the text layout cache
+            uint64_t ContentHash;
         };
         struct Batch
         {
             /// Renderer IDs required for OpenGL 
-            uint32_t VertexBufferId, IndexBufferId, VertexArrayId, ShaderProgramId;
+            uint32_t VertexArrayId, ShaderProgramId;
+            /// Programs of Quad.glsl specialized for each element type, by the element type index
+            std::array<uint32_t, FL_ELEMENT_TYPE_COUNT> VariantShaderProgramIds{};
+            QuadShaderStrategy ShaderStrategy = QuadShaderStrategy::UBER_SHADER;
+            /// Pass which the programs of `ShaderStrategy` are currently set to draw, see `SetQuadAlphaPass()`
+            QuadAlphaPass AlphaPass = QuadAlphaPass::ALL_FRAGMENTS;
+            /// Streams the instances of every flush to the GPU, see `InstanceRingBuffer`
+            std::shared_ptr<InstanceRingBuffer> InstanceRing;
+            /// Number of quads that the GPU buffers of the batch can currently hold
+            uint32_t QuadCapacity = 0;
+            /// Number of quads submitted in the current frame, across all the flushes
+            uint32_t FrameQuadCount = 0;
+            /// Highest `FrameQuadCount` observed so far, the batch grows when this exceeds `QuadCapacity`
+            uint32_t PeakQuadCount = 0;
+            /// Texture arrays used by the quads of the batch, each one is bound to the texture slot at its index
             std::vector<uint32_t> TextureIds;
-            /// All the vertices stored by a Batch.
-            std::vector<Vertex> Vertices;
+            /// All the quad instances stored by a Batch, each one is expanded into 6 vertices by the vertex shader
+            std::vector<QuadInstance> Instances;
+            /// Sort keys of `Instances`, see `MakeSortKey`, and the working memory which sorts them back to front before every flush
+            std::vector<uint64_t> SortKeys;
+            std::vector<uint32_t> SortedOrder, SortScratch;
+            std::vector<QuadInstance> SortedInstances;
+        };
+        /// MSDF bitmap of a single glyph in RGB8 format, generated before it is packed into the glyph atlas
+        struct GlyphBitmap
+        {
+            uint32_t             Codepoint;
+            uint32_t             Width, Height;
+            std::vector<uint8_t> Pixels;
+            flame::character     Metrics;
+        };
+        /// A range of instance slots of the retained batch owned by one user, e.g. a panel
+        struct RetainedRange
+        {
+            uint32_t Offset = 0, Count = 0;
+            /// Number of slots reserved for the range, slots past `Count` hold degenerate quads which produce no fragments
+            uint32_t Capacity = 0;
+            bool     IsValid = false;
+        };
+        /// Quads which are uploaded once and drawn every frame, until their range is recorded again
+        struct RetainedBatch
+        {
+            /// Renderer IDs required for OpenGL, the shader program of `s_Batch` is used for drawing
+            uint32_t InstanceBufferId, VertexArrayId;
+            /// Number of instances that the GPU buffer can hold
+            uint32_t BufferCapacity = 0;
+            /// Number of instance slots handed out to ranges or left behind by them, all of them are drawn
+            uint32_t AllocatedCount = 0;
+            std::vector<RetainedRange> Ranges;
+            /// Ids of destroyed ranges, handed out again by `CreateRetainedRange()`
+            std::vector<uint32_t>      FreeRangeIds;
+            /// CPU copy of the allocated instances, used to upload the buffer again after growing or compacting it
+            std::vector<QuadInstance>  Instances;
+            /// Quads added since `BeginRetainedRange()`
+            std::vector<QuadInstance>  RecordedInstances;
+            uint32_t                   RecordingRangeId = FL_INVALID_RETAINED_RANGE;
+            /// Set once the opaque pass of the frame is drawn, before the first flush of the batch at the latest, so that the quads of the frame are never depth tested against missing panels
+            bool                       IsOpaquePassDrawn = false;
+            /// Set when a range changes after the opaque pass of the frame, which is then drawn again at the end of the frame
+            bool                       IsChangedAfterOpaquePass = false;
+            /// Set when a range is recorded or the ranges are moved, after which they may not be laid out from back to front anymore
+            bool                       IsOrderDirty = false;
+            /// Scratch storage of `OrderRetainedRanges()`, the range ids from back to front
+            std::vector<uint32_t>      OrderedRangeIds;
+        };
+        struct PartialRedraw
+        {
+            bool                         IsEnabled = false;
+            float                        FullRedrawThreshold = 0.5f;
+            /// Holds the pixels of the previous frames, only the damaged region of it is drawn into
+            std::shared_ptr<Framebuffer> BackBuffer;
+            /// Bounds of all the damage reported in the current frame, in pixel units
+            Rect2D                       DamageBounds{ 0.0f };
+            bool                         HasDamage = false;
+            /// Set when the contents of the back buffer can't be reused, e.g. after the viewport or the theme changed
+            bool                         IsFullRedrawNeeded = true;
+            bool                         IsFrameDrawPrepared = false;
+            /// Set when nothing was damaged, the batches are then discarded instead of drawn
+            bool                         IsFrameDrawSkipped = false;
+        };
+        struct TextBatch
+        {
+            /// Renderer IDs required for OpenGL, the shader program is made from `Font.glsl`
+            uint32_t VertexArrayId, ShaderProgramId;
+            std::shared_ptr<InstanceRingBuffer> InstanceRing;
+            /// All the glyph instances stored by the text batch, all of them sample from the glyph atlas
+            std::vector<GlyphInstance> Instances;
         };
+    private:
+        /// Loads the glyph shape from the font and generates its MSDF bitmap, safe to call from worker threads as long as every thread has its own `fontHandle`.
+        /// Returns false if the font has no glyph for the code point
+        static bool GenerateGlyphBitmap(msdfgen::FontHandle* fontHandle, uint32_t codepoint, double borderWidth, GlyphBitmap& glyphBitmap);
     public:
         static FontProps& GetFontProps() { return s_FontProps; }
     private:
@@ -138,30 +496,60 @@ namespace FlameUI {
         static UniformBufferData                         s_UniformBufferData;
         /// Stores all the colors of the UI
         static ThemeInfo                                 s_ThemeInfo;
+        /// The RendererId of the Theme uniform buffer
+        static uint32_t                                  s_ThemeUniformBufferId;
+        /// Set when the theme uniform buffer is out of date, so that it is only uploaded when something changed
+        static bool                                      s_IsThemeDirty;
+        static uint32_t                                  s_ThemeRevision;
         /// Stores file path of the font provided by user and the default font file path
         static std::string                               s_UserFontFilePath;
+        /// Directory where the glyph atlas cache files are stored
+        static std::string                               s_FontCacheDirectory;
         /// The main vector of all the batches of quads to ever exist in the program
         static Batch                                     s_Batch;
-        /// Stores all the characters and their properties, which are extracted from the font provided by the user
-        static std::unordered_map<char, flame::character>s_Characters;
+        /// The quads of all the retained ranges, drawn in a single call
+        static RetainedBatch                             s_RetainedBatch;
+        /// State of the partial redraw mode, see `RendererInitInfo::enablePartialRedraw`
+        static PartialRedraw                             s_PartialRedraw;
+        /// The batch of all glyph quads, drawn in a single call using the glyph atlas
+        static TextBatch                                 s_TextBatch;
+        /// The paged texture which has all the currently loaded glyphs of the main UI font packed into it
+        static std::shared_ptr<GlyphAtlas>               s_GlyphAtlas;
+        /// Font handles kept open after loading the font, so that glyphs outside of the preloaded range can be generated on demand
+        static msdfgen::FreetypeHandle*                  s_FreetypeHandle;
+        static msdfgen::FontHandle*                      s_FontHandle;
+        /// Lays out and caches the text drawn using the main UI font
+        static std::shared_ptr<TextLayoutCache>          s_TextLayoutCache;
+        /// Worker threads used for CPU heavy work like generating the font glyphs
+        static std::shared_ptr<ThreadPool>               s_WorkerPool;
+        /// Stores all the loaded characters and their properties by code point, which are extracted from the font provided by the user
+        static std::unordered_map<uint32_t, flame::character> s_Characters;
+        /// Flat lookup table of the preloaded ASCII characters, pointing into `s_Characters`, the ASCII glyphs are pinned so the pointers stay valid
+        static std::array<const flame::character*, 128>  s_AsciiCharacters;
+        /// Code points which the font has no glyph for, so that generating them isn't retried every frame
+        static std::unordered_set<uint32_t>              s_MissingCodepoints;
+        /// Number of frames rendered so far, used to find the least recently used glyph atlas page
+        static uint64_t                                  s_FrameIndex;
         /// Stores the size of the vieport that FlameUI is being drawn on
         static glm::vec2                                 s_ViewportSize;
         /// Stores the cursor position per frame on the User Window
         static glm::vec2                                 s_CursorPosition;
         /// Stores the GLFWwindow where FlameUI is being drawn
         static GLFWwindow* s_UserWindow;
-        /// Stores the uniform location in a shader if the location needs to be reused
-        static std::unordered_map<std::string, GLint>    s_UniformLocationCache;
-        /// Stores the texture IDs of the already loaded textures to be reused
-        static std::unordered_map<std::string, uint32_t> s_TextureIdCache;
-
-        static float s_CurrentTextureSlot;
-
-        constexpr static glm::vec4 s_TemplateVertexPositions[4] = {
-             {-0.5f, -0.5f, 0.0f, 1.0f},
-             {-0.5f,  0.5f, 0.0f, 1.0f},
-             { 0.5f,  0.5f, 0.0f, 1.0f},
-             { 0.5f, -0.5f, 0.0f, 1.0f}
-        };
+        /// Uniform location tables of the shader programs created by `CreateShaderProgram()`, by program id, see `UniformLocationTable`
+        static std::unordered_map<uint32_t, UniformLocationTable> s_UniformLocationTables;
+        /// Texture arrays holding all the loaded textures
+        static std::shared_ptr<TextureArrayPool>         s_TextureArrayPool;
+        /// Streams in the textures of textured quads by the hash of their file path, within the texture memory budget
+        static std::shared_ptr<TextureCache>             s_TextureCache;
+        /// Number of texture slots the batch can use, the lower of `MAX_TEXTURE_SLOTS` and GL_MAX_TEXTURE_IMAGE_UNITS
+        static uint32_t                                  s_TextureSlotCount;
+        /// Stack of clip rectangles in pixel units, every one of them is already intersected with the ones below it
+        static std::vector<Rect2D>                       s_ClipRects;
+        /// The top of `s_ClipRects` rounded outwards to the `QuadInstance::clip_rect` format, which every quad added is clipped to
+        static std::array<int16_t, 4>                    s_PackedClipRect;
+        static uint32_t                                  s_RejectedQuadCount;
+        static uint32_t                                  s_QuadDrawCallCount;
+
     };
 }
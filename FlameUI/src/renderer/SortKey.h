@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+/// Number of bits of the layer of a draw, every layer is drawn above the lower layers regardless of the panel order
+#define FL_DRAW_LAYER_BITS 2
+/// Number of bits of the draw order of a panel, the panels are numbered again once the draw orders run out
+#define FL_DRAW_ORDER_BITS 16
+/// Number of bits of the sublayer of a draw within its panel
+#define FL_DRAW_SUBLAYER_BITS 4
+#define FL_MAX_DRAW_ORDER ((1u << FL_DRAW_ORDER_BITS) - 1)
+
+#define FL_DRAW_LAYER_PANELS 0
+#define FL_DRAW_LAYER_OVERLAY 1
+
+#define FL_DRAW_SUBLAYER_SHADOW 0
+#define FL_DRAW_SUBLAYER_PANEL 1
+#define FL_DRAW_SUBLAYER_BUTTON 2
+#define FL_DRAW_SUBLAYER_TEXT 3
+
+namespace FlameUI {
+    /// Returns the z value of a draw, draws with a higher layer, then a higher draw order, then a higher sublayer are in front.
+    /// The z values are multiples of 2^-23 in [0.5, 1), so every combination maps exactly to its own value in a 24-bit depth buffer
+    constexpr float GetDrawDepth(uint32_t layer, uint32_t drawOrder, uint32_t sublayer)
+    {
+        constexpr uint32_t levelCount = 1u << (FL_DRAW_LAYER_BITS + FL_DRAW_ORDER_BITS + FL_DRAW_SUBLAYER_BITS);
+        uint32_t level = (layer << (FL_DRAW_ORDER_BITS + FL_DRAW_SUBLAYER_BITS)) | (drawOrder << FL_DRAW_SUBLAYER_BITS) | sublayer;
+        return 1.0f - (float)(levelCount - level) / (float)(levelCount * 2);
+    }
+
+    /// Returns the 64-bit sort key of a draw, from the most significant bits: 32 bits of depth, 8 bits of material, i.e. the element type, and 16 bits of texture.
+    /// Sorting by the key draws back to front and groups the draws at the same depth by material and texture
+    inline uint64_t MakeSortKey(float depth, uint8_t material, uint16_t texture)
+    {
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &depth, sizeof(float));
+        // Flip all the bits of negative floats and the sign bit of positive ones, so that the bits order the same way as the floats
+        depthBits ^= (depthBits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+        return ((uint64_t)depthBits << 32) | ((uint64_t)material << 24) | ((uint64_t)texture << 8);
+    }
+}
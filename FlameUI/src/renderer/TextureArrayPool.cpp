@@ -0,0 +1,115 @@
+#include "TextureArrayPool.h"
+#include <algorithm>
+#include <glad/glad.h>
+#include "core/Core.h"
+#include "renderer/GLState.h"
+
+namespace FlameUI {
+    TextureArrayPool::~TextureArrayPool()
+    {
+        for (auto& textureArray : m_Arrays)
+        {
+            GLState::OnTextureDeleted(textureArray.TextureId);
+            glDeleteTextures(1, &textureArray.TextureId);
+        }
+    }
+
+    uint32_t TextureArrayPool::GetSizeClass(uint32_t width, uint32_t height)
+    {
+        uint32_t size = MIN_TEXTURE_SIZE_CLASS;
+        for (uint32_t sizeClass = 0; sizeClass < TEXTURE_SIZE_CLASS_COUNT; sizeClass++, size *= 2)
+        {
+            if (width <= size && height <= size)
+                return size;
+        }
+        return 0;
+    }
+
+    TextureArrayPool::TextureArray& TextureArrayPool::CreateArray(uint32_t size)
+    {
+        TextureArray textureArray;
+        textureArray.Size = size;
+        textureArray.LayerCount = std::clamp((uint32_t)(TEXTURE_ARRAY_MAX_BYTES / ((uint64_t)size * size * 4)), 1u, (uint32_t)TEXTURE_ARRAY_MAX_LAYERS);
+        // Layers are handed out from the back of the list, so the lowest layers are used first
+        for (uint32_t layer = textureArray.LayerCount; layer > 0; layer--)
+            textureArray.FreeLayers.push_back((uint16_t)(layer - 1));
+
+        glGenTextures(1, &textureArray.TextureId);
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, textureArray.TextureId);
+
+        // No mipmaps, as generating them would go over every layer of the array whenever a single texture is added
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GL_CHECK_ERROR(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, textureArray.LayerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+
+        m_AllocatedBytes += (uint64_t)size * size * 4 * textureArray.LayerCount;
+        m_Arrays.push_back(std::move(textureArray));
+        FL_INFO("Allocated a {0}x{0} texture array with {1} layers", size, m_Arrays.back().LayerCount);
+        return m_Arrays.back();
+    }
+
+    TextureLocation TextureArrayPool::Add(uint32_t width, uint32_t height, const uint8_t* pixels)
+    {
+        TextureLocation location = Allocate(width, height);
+        if (location.ArrayTextureId)
+            Upload(location, pixels);
+        return location;
+    }
+
+    TextureLocation TextureArrayPool::Allocate(uint32_t width, uint32_t height)
+    {
+        uint32_t size = GetSizeClass(width, height);
+        if (!size)
+        {
+            FL_WARN("Texture of size {0}x{1} is larger than the largest texture size class!", width, height);
+            return TextureLocation{};
+        }
+
+        auto it = std::find_if(m_Arrays.begin(), m_Arrays.end(), [size](const TextureArray& textureArray) { return textureArray.Size == size && !textureArray.FreeLayers.empty(); });
+        TextureArray& textureArray = it != m_Arrays.end() ? *it : CreateArray(size);
+
+        TextureLocation location;
+        location.ArrayTextureId = textureArray.TextureId;
+        location.Layer = textureArray.FreeLayers.back();
+        location.UVScale = { (float)width / size, (float)height / size };
+        location.Width = width;
+        location.Height = height;
+        textureArray.FreeLayers.pop_back();
+
+        m_UsedBytes += (uint64_t)size * size * 4;
+        return location;
+    }
+
+    void TextureArrayPool::Upload(const TextureLocation& location, const uint8_t* pixels)
+    {
+        GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, location.ArrayTextureId);
+        GL_CHECK_ERROR(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, location.Layer, location.Width, location.Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    }
+
+    uint32_t TextureArrayPool::GetUsedLayerCount(uint32_t arrayTextureId) const
+    {
+        auto it = std::find_if(m_Arrays.begin(), m_Arrays.end(), [arrayTextureId](const TextureArray& textureArray) { return textureArray.TextureId == arrayTextureId; });
+        return it != m_Arrays.end() ? it->LayerCount - (uint32_t)it->FreeLayers.size() : 0;
+    }
+
+    void TextureArrayPool::Remove(const TextureLocation& location)
+    {
+        auto it = std::find_if(m_Arrays.begin(), m_Arrays.end(), [&location](const TextureArray& textureArray) { return textureArray.TextureId == location.ArrayTextureId; });
+        FL_ASSERT(it != m_Arrays.end(), "Texture array {0} isn't part of the texture array pool!", location.ArrayTextureId);
+
+        // The old texels are simply overwritten by the texture stored in the layer next
+        it->FreeLayers.push_back(location.Layer);
+        m_UsedBytes -= (uint64_t)it->Size * it->Size * 4;
+
+        // A texture array without any textures left gives its memory back, so that evicting textures actually frees VRAM
+        if (it->FreeLayers.size() == it->LayerCount)
+        {
+            m_AllocatedBytes -= (uint64_t)it->Size * it->Size * 4 * it->LayerCount;
+            GLState::OnTextureDeleted(it->TextureId);
+            glDeleteTextures(1, &it->TextureId);
+            m_Arrays.erase(it);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// Width and height of the layers of the smallest size class, every following size class doubles it
+#define MIN_TEXTURE_SIZE_CLASS 32
+/// Number of size classes, textures larger than the layers of the last size class can't be added
+#define TEXTURE_SIZE_CLASS_COUNT 6
+/// Width and height of the layers of the largest size class
+#define MAX_TEXTURE_SIZE_CLASS (MIN_TEXTURE_SIZE_CLASS << (TEXTURE_SIZE_CLASS_COUNT - 1))
+/// Upper limit for the number of layers of a texture array
+#define TEXTURE_ARRAY_MAX_LAYERS 64
+/// Upper limit for the size of a texture array in bytes, the texture arrays of large size classes have fewer layers to stay below it
+#define TEXTURE_ARRAY_MAX_BYTES (16 * 1024 * 1024)
+
+namespace FlameUI {
+    /// Where a texture is stored in the texture arrays of a `TextureArrayPool`
+    struct TextureLocation
+    {
+        /// Opengl texture Id of the `GL_TEXTURE_2D_ARRAY` texture which holds the texture, 0 for no texture
+        uint32_t  ArrayTextureId = 0;
+        uint16_t  Layer = 0;
+        /// Fraction of the layer covered by the texture, textures smaller than their size class only fill the bottom left corner of the layer
+        glm::vec2 UVScale{ 0.0f };
+        /// Size of the texture in pixels
+        uint32_t  Width = 0, Height = 0;
+    };
+
+    /// Stores RGBA8 textures in the layers of `GL_TEXTURE_2D_ARRAY` textures, with a texture array for every power of 2 size class.
+    /// A batch binds texture arrays instead of single textures, so that every texture of the same size class takes up only one texture slot
+    class TextureArrayPool
+    {
+    public:
+        TextureArrayPool() = default;
+        ~TextureArrayPool();
+
+        /// Copies the RGBA8 pixels into a free layer of the smallest size class that fits them, allocating a new texture array if all of them are full
+        TextureLocation Add(uint32_t width, uint32_t height, const uint8_t* pixels);
+        /// Reserves a free layer for a texture of the given size without uploading anything, returns an empty location if the texture is too large
+        TextureLocation Allocate(uint32_t width, uint32_t height);
+        /// Uploads the RGBA8 pixels of a texture into its allocated layer, `pixels` is an offset into the buffer bound to GL_PIXEL_UNPACK_BUFFER if there is one
+        void            Upload(const TextureLocation& location, const uint8_t* pixels);
+        /// Frees the layer of the texture, so that the next texture of the same size class can be stored in it, texture arrays left empty are deleted
+        void            Remove(const TextureLocation& location);
+        /// Returns the number of bytes of the layers that hold a texture, see `GetAllocatedBytes()` for the size of the texture arrays themselves
+        uint64_t        GetUsedBytes() const { return m_UsedBytes; }
+        uint64_t        GetAllocatedBytes() const { return m_AllocatedBytes; }
+        uint32_t        GetArrayCount() const { return (uint32_t)m_Arrays.size(); }
+        /// Returns the number of layers of the texture array which hold a texture, the texture array is deleted once none of them do
+        uint32_t        GetUsedLayerCount(uint32_t arrayTextureId) const;
+
+        /// Returns the width and height of the layers of the smallest size class that fits a texture of the given size, or 0 if none does
+        static uint32_t GetSizeClass(uint32_t width, uint32_t height);
+    private:
+        struct TextureArray
+        {
+            uint32_t              TextureId = 0;
+            uint32_t              Size = 0;
+            uint32_t              LayerCount = 0;
+            std::vector<uint16_t> FreeLayers;
+        };
+    private:
+        /// Allocates a texture array of the size class with all of its layers free
+        TextureArray& CreateArray(uint32_t size);
+    private:
+        std::vector<TextureArray> m_Arrays;
+        uint64_t                  m_UsedBytes = 0, m_AllocatedBytes = 0;
+    };
+}
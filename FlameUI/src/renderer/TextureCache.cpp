@@ -0,0 +1,139 @@
+#include "TextureCache.h"
+#include <vector>
+#include <algorithm>
+#include "core/Core.h"
+
+namespace FlameUI {
+    TextureCache::TextureCache(const std::shared_ptr<ThreadPool>& workerPool, const std::shared_ptr<TextureArrayPool>& textureArrayPool, uint64_t budgetBytes)
+        : m_TextureArrayPool(textureArrayPool), m_Streamer(workerPool, textureArrayPool)
+    {
+        const uint8_t placeholderPixel[4] = { 0x80, 0x80, 0x80, 0xff };
+        m_PlaceholderTexture = m_TextureArrayPool->Add(1, 1, placeholderPixel);
+        m_Stats.BudgetBytes = budgetBytes;
+    }
+
+    TextureCache::~TextureCache()
+    {
+        for (auto& [key, entry] : m_Entries)
+        {
+            if (entry.IsResident)
+                m_TextureArrayPool->Remove(entry.Location);
+        }
+        m_TextureArrayPool->Remove(m_PlaceholderTexture);
+    }
+
+    const TextureLocation& TextureCache::Get(HashedId filePath, uint64_t frameIndex)
+    {
+        auto [it, isInserted] = m_Entries.try_emplace(filePath.Hash);
+        Entry& entry = it->second;
+        if (!isInserted)
+        {
+            // Two paths with the same hash can't share the entry, the one which came second draws the placeholder
+            if (entry.FilePath != filePath.Name)
+            {
+                if (!entry.IsCollisionReported)
+                    FL_WARN("Texture \"{0}\" has the same path hash as \"{1}\", it won't be loaded!", filePath.Name, entry.FilePath);
+                entry.IsCollisionReported = true;
+                return m_PlaceholderTexture;
+            }
+            entry.LastUsedFrame = frameIndex;
+            m_Stats.HitCount++;
+            return entry.IsResident ? entry.Location : m_PlaceholderTexture;
+        }
+
+        entry.FilePath = filePath.Name;
+        entry.LastUsedFrame = frameIndex;
+        m_Stats.MissCount++;
+        m_Stats.PendingCount++;
+        m_Streamer.Request(filePath.Hash, filePath.Name);
+        return m_PlaceholderTexture;
+    }
+
+    bool TextureCache::Update(uint64_t frameIndex)
+    {
+        bool isAnyTextureResident = false;
+        m_Streamer.Update([&](uint64_t key, const TextureLocation& location)
+            {
+                m_Stats.PendingCount--;
+                auto it = m_Entries.find(key);
+                // Textures which failed to load keep drawing the placeholder
+                if (!location.ArrayTextureId || it == m_Entries.end())
+                {
+                    if (location.ArrayTextureId)
+                        m_TextureArrayPool->Remove(location);
+                    return;
+                }
+
+                uint32_t sizeClass = TextureArrayPool::GetSizeClass(location.Width, location.Height);
+                it->second.Location = location;
+                it->second.ByteSize = (uint64_t)sizeClass * sizeClass * 4;
+                it->second.IsResident = true;
+                m_Stats.ResidentCount++;
+                m_Stats.ResidentBytes += it->second.ByteSize;
+                isAnyTextureResident = true;
+            }
+        );
+
+        if (m_TextureArrayPool->GetAllocatedBytes() > m_Stats.BudgetBytes)
+            EvictLeastRecentlyUsed(frameIndex);
+        m_Stats.AllocatedBytes = m_TextureArrayPool->GetAllocatedBytes();
+        return isAnyTextureResident;
+    }
+
+    void TextureCache::EvictLeastRecentlyUsed(uint64_t frameIndex)
+    {
+        // Evicting single textures rarely empties a texture array, so the textures are evicted an array at a time
+        for (auto& [arrayTextureId, entries] : m_EntriesByArray)
+            entries.clear();
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+        {
+            if (it->second.IsResident)
+                m_EntriesByArray[it->second.Location.ArrayTextureId].push_back(it);
+        }
+
+        struct EvictableArray
+        {
+            uint32_t ArrayTextureId;
+            uint64_t LastUsedFrame;
+        };
+        std::vector<EvictableArray> evictableArrays;
+        for (const auto& [arrayTextureId, entries] : m_EntriesByArray)
+        {
+            // Arrays which also hold the placeholder or textures created outside of the cache would stay allocated anyway
+            if (entries.empty() || entries.size() < m_TextureArrayPool->GetUsedLayerCount(arrayTextureId))
+                continue;
+
+            uint64_t lastUsedFrame = 0;
+            for (auto it : entries)
+                lastUsedFrame = std::max(lastUsedFrame, it->second.LastUsedFrame);
+            if (lastUsedFrame + 1 < frameIndex)
+                evictableArrays.push_back({ arrayTextureId, lastUsedFrame });
+        }
+        std::sort(evictableArrays.begin(), evictableArrays.end(), [](const EvictableArray& a, const EvictableArray& b) { return a.LastUsedFrame < b.LastUsedFrame; });
+
+        uint32_t evictionCount = 0;
+        for (const EvictableArray& evictableArray : evictableArrays)
+        {
+            if (m_TextureArrayPool->GetAllocatedBytes() <= m_Stats.BudgetBytes)
+                break;
+            for (auto it : m_EntriesByArray[evictableArray.ArrayTextureId])
+            {
+                m_TextureArrayPool->Remove(it->second.Location);
+                m_Stats.ResidentCount--;
+                m_Stats.ResidentBytes -= it->second.ByteSize;
+                m_Stats.EvictedBytes += it->second.ByteSize;
+                m_Stats.EvictionCount++;
+                evictionCount++;
+                // The entry is forgotten, so that the texture is streamed in again the next time it is used
+                m_Entries.erase(it);
+            }
+        }
+
+        uint64_t allocatedBytes = m_TextureArrayPool->GetAllocatedBytes();
+        if (evictionCount)
+            FL_INFO("Evicted {0} textures from the texture cache, {1} of {2} bytes allocated", evictionCount, allocatedBytes, m_Stats.BudgetBytes);
+        if (allocatedBytes > m_Stats.BudgetBytes && !m_IsOverBudgetReported)
+            FL_WARN("The texture arrays of the textures on screen take up {0} bytes, which is more than the texture cache budget of {1} bytes!", allocatedBytes, m_Stats.BudgetBytes);
+        m_IsOverBudgetReported = allocatedBytes > m_Stats.BudgetBytes;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "renderer/TextureArrayPool.h"
+#include "renderer/TextureStreamer.h"
+#include "utils/Hash.h"
+
+namespace FlameUI {
+    /// Residency and eviction statistics of a `TextureCache`, the counts are totals since the cache was created
+    struct TextureCacheStats
+    {
+        uint32_t ResidentCount = 0, PendingCount = 0;
+        /// Bytes of the texture array layers taken up by the resident textures
+        uint64_t ResidentBytes = 0;
+        /// Bytes of all the texture arrays of the pool, free layers included
+        uint64_t AllocatedBytes = 0;
+        uint64_t BudgetBytes = 0;
+        uint64_t HitCount = 0, MissCount = 0;
+        uint64_t EvictionCount = 0, EvictedBytes = 0;
+    };
+
+    /// Textures of image files by the hash of their path, streamed in by a `TextureStreamer` and stored in a `TextureArrayPool`.
+    /// Once the texture arrays of the pool take up more than the budget, the least recently used textures are evicted and streamed in again when they are used next.
+    /// The budget is compared with the memory of the texture arrays rather than of the layers in use, as a texture array only frees its memory once it is empty
+    class TextureCache
+    {
+    public:
+        TextureCache(const std::shared_ptr<ThreadPool>& workerPool, const std::shared_ptr<TextureArrayPool>& textureArrayPool, uint64_t budgetBytes);
+        ~TextureCache();
+
+        /// Returns the texture of the image file and marks it as used in the frame, a texture which isn't resident yet returns the placeholder texture
+        const TextureLocation& Get(HashedId filePath, uint64_t frameIndex);
+        /// Makes the textures streamed in since the last call resident and evicts textures while over the budget, returns true if a texture became resident
+        bool                   Update(uint64_t frameIndex);
+        const TextureCacheStats& GetStats() const { return m_Stats; }
+    private:
+        struct Entry
+        {
+            /// Path of the image file, compared on every lookup as the entries are keyed by its hash only
+            std::string     FilePath;
+            TextureLocation Location;
+            uint64_t        LastUsedFrame = 0;
+            uint64_t        ByteSize = 0;
+            bool            IsResident = false;
+            /// Set once another file with the same path hash was looked up, so that it is only reported once
+            bool            IsCollisionReported = false;
+        };
+    private:
+        /// Evicts the textures of whole texture arrays, the array whose textures were used the least recently first, until the texture arrays fit in the budget.
+        /// Textures used in the current or the previous frame are still on screen and are never evicted, neither are the arrays which hold them or textures not owned by the cache
+        void EvictLeastRecentlyUsed(uint64_t frameIndex);
+    private:
+        std::shared_ptr<TextureArrayPool>      m_TextureArrayPool;
+        TextureStreamer                        m_Streamer;
+        /// Drawn in place of the textures which are still being streamed in
+        TextureLocation                        m_PlaceholderTexture;
+        std::unordered_map<uint64_t, Entry>    m_Entries;
+        TextureCacheStats                      m_Stats;
+        /// Set once the texture arrays which can't be evicted alone exceed the budget, so that it is only reported once
+        bool                                   m_IsOverBudgetReported = false;
+        /// Scratch storage of the eviction, the entries of the cache grouped by their texture array
+        std::unordered_map<uint32_t, std::vector<std::unordered_map<uint64_t, Entry>::iterator>> m_EntriesByArray;
+    };
+}
@@ -0,0 +1,178 @@
+#include "TextureStreamer.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include <stb_image/stb_image.h>
+#include "core/Core.h"
+#include "renderer/GLState.h"
+
+namespace FlameUI {
+    /// Box filters the image down to the given size, every destination pixel is the average of the source pixels it covers
+    static void DownscaleImage(DecodedImage& image, uint32_t width, uint32_t height)
+    {
+        uint8_t* pixels = (uint8_t*)std::malloc((size_t)width * height * 4);
+        const uint8_t* sourcePixels = image.Pixels.get();
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint32_t sourceY0 = (uint32_t)((uint64_t)y * image.Height / height);
+            uint32_t sourceY1 = std::max(sourceY0 + 1, (uint32_t)((uint64_t)(y + 1) * image.Height / height));
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint32_t sourceX0 = (uint32_t)((uint64_t)x * image.Width / width);
+                uint32_t sourceX1 = std::max(sourceX0 + 1, (uint32_t)((uint64_t)(x + 1) * image.Width / width));
+
+                uint32_t sum[4] = { 0, 0, 0, 0 };
+                for (uint32_t sourceY = sourceY0; sourceY < sourceY1; sourceY++)
+                {
+                    for (uint32_t sourceX = sourceX0; sourceX < sourceX1; sourceX++)
+                    {
+                        const uint8_t* texel = sourcePixels + ((size_t)sourceY * image.Width + sourceX) * 4;
+                        for (uint32_t channel = 0; channel < 4; channel++)
+                            sum[channel] += texel[channel];
+                    }
+                }
+
+                uint32_t texelCount = (sourceX1 - sourceX0) * (sourceY1 - sourceY0);
+                uint8_t* texel = pixels + ((size_t)y * width + x) * 4;
+                for (uint32_t channel = 0; channel < 4; channel++)
+                    texel[channel] = (uint8_t)((sum[channel] + texelCount / 2) / texelCount);
+            }
+        }
+
+        image.Width = width;
+        image.Height = height;
+        image.Pixels = std::unique_ptr<uint8_t, void (*)(void*)>(pixels, std::free);
+    }
+
+    bool DecodeImage(const std::string& filePath, DecodedImage& image)
+    {
+        // OpenGL expects the bottom row first, the flag is thread local so the worker threads don't race on it
+        stbi_set_flip_vertically_on_load_thread(1);
+
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(filePath.c_str(), &width, &height, &channels, 4);
+        if (!pixels)
+        {
+            FL_WARN("Failed to load texture from \"{0}\": {1}", filePath, stbi_failure_reason());
+            return false;
+        }
+
+        image.Width = (uint32_t)width;
+        image.Height = (uint32_t)height;
+        image.Pixels = std::unique_ptr<uint8_t, void (*)(void*)>(pixels, stbi_image_free);
+
+        // Done here so that the worker threads pay for it, the texture array pool has no layers for larger textures
+        uint32_t largestSide = std::max(image.Width, image.Height);
+        if (largestSide > MAX_TEXTURE_SIZE_CLASS)
+        {
+            uint32_t width = std::max((uint32_t)((uint64_t)image.Width * MAX_TEXTURE_SIZE_CLASS / largestSide), 1u);
+            uint32_t height = std::max((uint32_t)((uint64_t)image.Height * MAX_TEXTURE_SIZE_CLASS / largestSide), 1u);
+            FL_INFO("Downscaling texture \"{0}\" from {1}x{2} to {3}x{4}", filePath, image.Width, image.Height, width, height);
+            DownscaleImage(image, width, height);
+        }
+        return true;
+    }
+
+    TextureStreamer::TextureStreamer(const std::shared_ptr<ThreadPool>& workerPool, const std::shared_ptr<TextureArrayPool>& textureArrayPool)
+        : m_WorkerPool(workerPool), m_TextureArrayPool(textureArrayPool), m_DecodedQueue(std::make_shared<DecodedQueue>())
+    {
+        glGenBuffers(1, &m_PixelBufferId);
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        GLState::OnBufferDeleted(m_PixelBufferId);
+        glDeleteBuffers(1, &m_PixelBufferId);
+    }
+
+    void TextureStreamer::Request(uint64_t key, const std::string& filePath)
+    {
+        m_PendingCount++;
+        m_WorkerPool->Submit([decodedQueue = m_DecodedQueue, key, filePath]()
+            {
+                DecodedTexture texture{ key, false, DecodedImage{} };
+                texture.IsDecoded = DecodeImage(filePath, texture.Image);
+
+                std::lock_guard<std::mutex> lock(decodedQueue->Mutex);
+                decodedQueue->Textures.push_back(std::move(texture));
+            }
+        );
+    }
+
+    void TextureStreamer::Update(const OnTextureResident& onTextureResident)
+    {
+        // Take the decoded textures that fit in the budget of this frame, the rest stay queued
+        std::vector<DecodedTexture> textures;
+        size_t uploadSize = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_DecodedQueue->Mutex);
+            auto& queuedTextures = m_DecodedQueue->Textures;
+            while (!queuedTextures.empty())
+            {
+                size_t textureSize = queuedTextures.front().Image.GetByteSize();
+                if (!textures.empty() && uploadSize + textureSize > TEXTURE_UPLOAD_BYTES_PER_FRAME)
+                    break;
+                uploadSize += textureSize;
+                textures.push_back(std::move(queuedTextures.front()));
+                queuedTextures.pop_front();
+            }
+        }
+        if (textures.empty())
+            return;
+
+        // The layers are allocated before the pixel buffer is bound, as allocating a new texture array must not read from it
+        std::vector<TextureLocation> locations(textures.size());
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            if (textures[i].IsDecoded)
+                locations[i] = m_TextureArrayPool->Allocate(textures[i].Image.Width, textures[i].Image.Height);
+        }
+
+        if (uploadSize)
+        {
+            GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBufferId);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, uploadSize, nullptr, GL_STREAM_DRAW);
+            uint8_t* mappedData = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, uploadSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (!mappedData)
+            {
+                // Nothing is uploaded this frame, the textures go back to the front of the queue in their order and are retried next frame
+                FL_WARN("Failed to map the texture upload buffer of {0} bytes, retrying next frame", uploadSize);
+                GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                for (const auto& location : locations)
+                {
+                    if (location.ArrayTextureId)
+                        m_TextureArrayPool->Remove(location);
+                }
+
+                std::lock_guard<std::mutex> lock(m_DecodedQueue->Mutex);
+                for (auto it = textures.rbegin(); it != textures.rend(); ++it)
+                    m_DecodedQueue->Textures.push_front(std::move(*it));
+                return;
+            }
+
+            std::vector<size_t> offsets(textures.size());
+            size_t offset = 0;
+            for (size_t i = 0; i < textures.size(); i++)
+            {
+                offsets[i] = offset;
+                if (textures[i].IsDecoded)
+                    memcpy(mappedData + offset, textures[i].Image.Pixels.get(), textures[i].Image.GetByteSize());
+                offset += textures[i].Image.GetByteSize();
+            }
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            // With the pixel buffer bound, the pixels passed to the upload are offsets into it and the copy happens asynchronously
+            for (size_t i = 0; i < textures.size(); i++)
+            {
+                if (locations[i].ArrayTextureId)
+                    m_TextureArrayPool->Upload(locations[i], reinterpret_cast<const uint8_t*>(offsets[i]));
+            }
+            GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+
+        m_PendingCount -= (uint32_t)textures.size();
+        for (size_t i = 0; i < textures.size(); i++)
+            onTextureResident(textures[i].Key, locations[i]);
+    }
+}
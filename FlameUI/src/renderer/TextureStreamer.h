@@ -0,0 +1,68 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "renderer/TextureArrayPool.h"
+#include "utils/ThreadPool.h"
+
+/// Number of bytes of decoded pixels uploaded per frame at most, textures decoded beyond it wait for the following frames.
+/// A single texture larger than this is still uploaded, on its own in one frame
+#define TEXTURE_UPLOAD_BYTES_PER_FRAME (4 * 1024 * 1024)
+
+namespace FlameUI {
+    /// Pixels of an image file decoded to RGBA8, with the first row being the bottom of the image
+    struct DecodedImage
+    {
+        uint32_t                                 Width = 0, Height = 0;
+        std::unique_ptr<uint8_t, void (*)(void*)> Pixels{ nullptr, nullptr };
+
+        size_t GetByteSize() const { return (size_t)Width * Height * 4; }
+    };
+
+    /// Decodes the image file using stb_image, returns false if it can't be read. Safe to call from any thread.
+    /// Images larger than the largest texture size class are downscaled to fit it, keeping their aspect ratio
+    bool DecodeImage(const std::string& filePath, DecodedImage& image);
+
+    /// Loads textures without stalling the frame: the image files are decoded by the worker threads and the decoded pixels are copied
+    /// into the layers of the `TextureArrayPool` through a pixel buffer object, at most `TEXTURE_UPLOAD_BYTES_PER_FRAME` bytes per frame
+    class TextureStreamer
+    {
+    public:
+        /// Called on the render thread once the texture is resident, with an empty location if the image couldn't be decoded or stored
+        using OnTextureResident = std::function<void(uint64_t key, const TextureLocation& location)>;
+    public:
+        TextureStreamer(const std::shared_ptr<ThreadPool>& workerPool, const std::shared_ptr<TextureArrayPool>& textureArrayPool);
+        ~TextureStreamer();
+
+        /// Queues the image file to be decoded by a worker thread, `key` identifies the texture once it is resident
+        void     Request(uint64_t key, const std::string& filePath);
+        /// Uploads the textures decoded since the last call, up to the per frame budget, has to be called on the render thread
+        void     Update(const OnTextureResident& onTextureResident);
+        /// Number of textures requested which aren't resident yet
+        uint32_t GetPendingCount() const { return m_PendingCount; }
+    private:
+        struct DecodedTexture
+        {
+            uint64_t     Key;
+            bool         IsDecoded;
+            DecodedImage Image;
+        };
+        /// Shared with the tasks of the worker threads, which can outlive the streamer
+        struct DecodedQueue
+        {
+            std::mutex                 Mutex;
+            std::deque<DecodedTexture> Textures;
+        };
+    private:
+        std::shared_ptr<ThreadPool>       m_WorkerPool;
+        std::shared_ptr<TextureArrayPool> m_TextureArrayPool;
+        std::shared_ptr<DecodedQueue>     m_DecodedQueue;
+        /// Buffer bound to GL_PIXEL_UNPACK_BUFFER for the uploads, orphaned every frame so that the driver never waits for the previous uploads
+        uint32_t                          m_PixelBufferId = 0;
+        uint32_t                          m_PendingCount = 0;
+    };
+}
@@ -9,14 +9,14 @@ namespace FlameUI {
 
     void Button::OnDraw()
     {
-        if (m_ButtonInfo.pressState == PressState::Hovered)
-            Renderer::AddQuad(m_ButtonInfo.position, m_ButtonInfo.dimensions, Renderer::GetThemeInfo().buttonHoveredColor, FL_ELEMENT_TYPE_BUTTON_INDEX);
-        else
-            Renderer::AddQuad(m_ButtonInfo.position, m_ButtonInfo.dimensions, Renderer::GetThemeInfo().buttonColor, FL_ELEMENT_TYPE_BUTTON_INDEX);
+        // The press states are in the same order as the button styles, the shader picks the matching theme color
+        uint16_t styleIndex = FL_STYLE_BUTTON_INDEX + (uint16_t)m_ButtonInfo.pressState;
+        Renderer::AddStyledQuad(m_ButtonInfo.position, m_ButtonInfo.dimensions, styleIndex, FL_ELEMENT_TYPE_BUTTON_INDEX);
     }
 
     void Button::UpdateMetrics(const glm::vec3& pos, const glm::vec2& dim)
     {
+        m_IsDirty |= pos != m_ButtonInfo.position || dim != m_ButtonInfo.dimensions;
         m_ButtonInfo.UpdateMetrics(pos, dim);
     }
 
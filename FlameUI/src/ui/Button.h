@@ -38,9 +38,25 @@ namespace FlameUI {
         void OnDraw();
         const ButtonInfo& GetButtonInfo() const { return m_ButtonInfo; }
         void UpdateMetrics(const glm::vec3& pos, const glm::vec2& dim);
-        inline void SetPressState(const PressState& pressState) { m_ButtonInfo.pressState = pressState; }
+        inline void SetPressState(const PressState& pressState)
+        {
+            m_IsDirty |= m_ButtonInfo.pressState != pressState;
+            m_ButtonInfo.pressState = pressState;
+        }
         inline PressState GetPressState() const { return m_ButtonInfo.pressState; }
+        /// Returns true if the button looks different since its quads were last recorded by the panel
+        bool IsDirty() const { return m_IsDirty; }
+        void ClearDirty() { m_IsDirty = false; }
+        /// Occluded buttons are completely hidden behind opaque panels in front of them, their panel records no quads for them
+        void SetOccluded(bool isOccluded)
+        {
+            m_IsDirty |= m_IsOccluded != isOccluded;
+            m_IsOccluded = isOccluded;
+        }
+        bool IsOccluded() const { return m_IsOccluded; }
     private:
         ButtonInfo m_ButtonInfo;
+        bool       m_IsDirty = true;
+        bool       m_IsOccluded = false;
     };
 }
\ No newline at end of file
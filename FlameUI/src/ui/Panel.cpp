@@ -1,13 +1,12 @@
 #include "Panel.h"
 #include "core/Core.h"
 #include "utils/Timer.h"
-
-#define FL_VERY_SMALL_NUMBER 0.000001f
+#include "renderer/SortKey.h"
 
 namespace FlameUI {
     Panel::Panel(const std::string& title, const glm::vec2& position, const glm::vec2& dimensions, const glm::vec4& color)
         : m_PanelName(title),
-        m_Position({ position.x, position.y, 0.0f }),
+        m_Position({ position.x, position.y, GetDrawDepth(FL_DRAW_LAYER_PANELS, 0, FL_DRAW_SUBLAYER_PANEL) }),
         m_Dimensions(dimensions),
         m_InnerPadding(15, 10),
         m_Color(color),
@@ -24,6 +23,16 @@ namespace FlameUI {
         InvalidateBounds();
     }
 
+    Panel::~Panel()
+    {
+        // The panel uncovers whatever it was drawn over
+        if (m_RetainedRangeId.Value != FL_INVALID_RETAINED_RANGE)
+        {
+            Renderer::AddDamageRect(m_LastDrawnRect2D);
+            Renderer::DestroyRetainedRange(m_RetainedRangeId.Value);
+        }
+    }
+
     bool Panel::IsHoveredOnPanel()
     {
         glm::vec2& cursor_pos = Renderer::GetCursorPosition();
@@ -42,15 +51,65 @@ namespace FlameUI {
 
     void Panel::OnDraw()
     {
-        // Render the panel
-        Renderer::AddQuad(m_Position, m_Dimensions, m_Color, FL_ELEMENT_TYPE_PANEL_INDEX, UnitType::PIXEL_UNITS, m_IsFocused);
+        // The range is created here rather than in the constructor, as panels are moved around while they are being submitted
+        if (m_RetainedRangeId.Value == FL_INVALID_RETAINED_RANGE)
+            m_RetainedRangeId.Value = Renderer::CreateRetainedRange();
+
+        // Updating Button Positions, which marks the buttons dirty if the panel moved
+        if (m_IsDirty)
+            InvalidateButtonPos();
+
+        // Whole panels are accepted or rejected against the viewport, so that an offscreen panel generates no quads at all
+        bool isOffscreen = !Renderer::IsRect2DVisible(GetBounds());
+        m_IsDirty |= isOffscreen != m_IsOffscreen;
+        m_IsOffscreen = isOffscreen;
+
+        // A change of the panel itself damages both where it was and where it is now, otherwise only the changed buttons are damaged
+        bool isDirty = m_IsDirty || !Renderer::IsRetainedRangeValid(m_RetainedRangeId.Value);
+        if (isDirty)
+        {
+            Renderer::AddDamageRect(m_LastDrawnRect2D);
+            Renderer::AddDamageRect(Renderer::GetPanelShadowBounds(m_PanelRect2D));
+        }
+        for (auto& button : m_Buttons)
+        {
+            if (!button.IsDirty())
+                continue;
+            isDirty = true;
+
+            const glm::vec3& buttonPosition = button.GetButtonInfo().position;
+            const glm::vec2& buttonDimensions = button.GetButtonInfo().dimensions;
+            Renderer::AddDamageRect({ buttonPosition.x - buttonDimensions.x / 2.0f, buttonPosition.x + buttonDimensions.x / 2.0f, buttonPosition.y - buttonDimensions.y / 2.0f, buttonPosition.y + buttonDimensions.y / 2.0f });
+        }
 
-        // Updating Button Positions
-        InvalidateButtonPos();
+        // The quads of an unchanged panel stay on the GPU from the last time they were recorded
+        if (!isDirty)
+            return;
 
-        // Render all the buttons
+        // An occluded or offscreen panel leaves its range empty, so that the hidden quads aren't shaded every frame
+        bool isHidden = m_IsOccluded || m_IsOffscreen;
+        Renderer::BeginRetainedRange(m_RetainedRangeId.Value);
+
+        // Render the panel above its drop shadow
+        if (!isHidden)
+        {
+            Renderer::AddPanelShadow({ m_Position.x, m_Position.y, GetDrawDepth(FL_DRAW_LAYER_PANELS, m_DrawOrder, FL_DRAW_SUBLAYER_SHADOW) }, m_Dimensions);
+            Renderer::AddQuad(m_Position, m_Dimensions, m_Color, FL_ELEMENT_TYPE_PANEL_INDEX, UnitType::PIXEL_UNITS, m_IsFocused);
+        }
+
+        // Render all the buttons clipped to the panel, the ones entirely outside of it are rejected
+        Renderer::PushClipRect(m_PanelRect2D);
         for (auto& button : m_Buttons)
-            button.OnDraw();
+        {
+            if (!isHidden && !button.IsOccluded())
+                button.OnDraw();
+            button.ClearDirty();
+        }
+        Renderer::PopClipRect();
+
+        Renderer::EndRetainedRange();
+        m_IsDirty = false;
+        m_LastDrawnRect2D = Renderer::GetPanelShadowBounds(m_PanelRect2D);
     }
 
     void Panel::InvalidateButtonPos()
@@ -64,13 +123,17 @@ namespace FlameUI {
 
             buttonPosition.x = m_PanelRect2D.l + m_InnerPadding.x + buttonDimensions.x / 2.0f;
             buttonPosition.y = m_PanelRect2D.t - TITLE_BAR_HEIGHT - m_InnerPadding.y - buttonDimensions.y / 2.0f;
-            buttonPosition.z = m_Position.z + FL_VERY_SMALL_NUMBER;
+            buttonPosition.z = GetDrawDepth(FL_DRAW_LAYER_PANELS, m_DrawOrder, FL_DRAW_SUBLAYER_BUTTON);
             button.UpdateMetrics(buttonPosition, buttonDimensions);
         }
     }
 
     void Panel::UpdateMetrics(const glm::vec2& position, const glm::vec2& dimensions)
     {
+        if (position.x == m_Position.x && position.y == m_Position.y && dimensions == m_Dimensions)
+            return;
+
+        m_IsDirty = true;
         m_Position = { position, m_Position.z };
         m_Dimensions = dimensions;
         InvalidateBounds();
@@ -78,11 +141,47 @@ namespace FlameUI {
 
     void Panel::AddButton(const std::string& text, const glm::vec2& dimensions)
     {
-        m_Buttons.emplace_back(ButtonInfo{ text, glm::vec3{ m_Position.x, m_Position.y, m_Position.z + 0.0000000001f }, dimensions });
+        m_Buttons.emplace_back(ButtonInfo{ text, glm::vec3{ m_Position.x, m_Position.y, GetDrawDepth(FL_DRAW_LAYER_PANELS, m_DrawOrder, FL_DRAW_SUBLAYER_BUTTON) }, dimensions });
+        m_IsDirty = true;
+    }
+
+    void Panel::SetDrawOrder(uint32_t drawOrder)
+    {
+        FL_ASSERT(drawOrder <= FL_MAX_DRAW_ORDER, "Draw order {0} of panel '{1}' doesn't fit in the depth of a draw!", drawOrder, m_PanelName);
+        m_IsDirty |= drawOrder != m_DrawOrder;
+        m_DrawOrder = drawOrder;
+        m_Position.z = GetDrawDepth(FL_DRAW_LAYER_PANELS, drawOrder, FL_DRAW_SUBLAYER_PANEL);
     }
 
-    void Panel::SetZIndex(float z) { m_Position.z = z; }
-    void Panel::SetFocus(bool value) { m_IsFocused = value; }
+    void Panel::SetFocus(bool value)
+    {
+        m_IsDirty |= value != m_IsFocused;
+        m_IsFocused = value;
+    }
+
+    void Panel::SetOccluded(bool isOccluded)
+    {
+        m_IsDirty |= isOccluded != m_IsOccluded;
+        m_IsOccluded = isOccluded;
+    }
+
+    Rect2D Panel::GetBounds() const
+    {
+        Rect2D bounds = Renderer::GetPanelShadowBounds(m_PanelRect2D);
+        for (const auto& button : m_Buttons)
+        {
+            const Rect2D& buttonRect2D = button.GetButtonInfo().buttonRect2D;
+            bounds = { std::min(bounds.l, buttonRect2D.l), std::max(bounds.r, buttonRect2D.r), std::min(bounds.b, buttonRect2D.b), std::max(bounds.t, buttonRect2D.t) };
+        }
+        return bounds;
+    }
+
+    bool Panel::IsOpaque()
+    {
+        // The panel quad is shaded entirely with the theme colors, see GetPanelColor() in Quad.glsl
+        const ThemeInfo& themeInfo = Renderer::GetThemeInfo();
+        return themeInfo.panelCornerRadius <= 0.0f && themeInfo.panelBgColor.w >= 1.0f && themeInfo.panelTitleBarActiveColor.w >= 1.0f && themeInfo.panelTitleBarInactiveColor.w >= 1.0f && themeInfo.borderColor.w >= 1.0f;
+    }
 
     std::shared_ptr<Panel> Panel::Create(const std::string& title, const glm::vec2& position, const glm::vec2& dimensions, const glm::vec4& color)
     {
@@ -1,4 +1,5 @@
 #pragma once
+#include <utility>
 #include <vector>
 #include "renderer/Renderer.h"
 #include "Button.h"
@@ -23,7 +24,13 @@ namespace FlameUI {
     {
     public:
         Panel(const std::string& title = "Untitled Panel", const glm::vec2& position = glm::vec2{ 0.0f }, const glm::vec2& dimensions = glm::vec2{ 100.0f }, const glm::vec4& color = FL_WHITE);
-        ~Panel() = default;
+        // Panels own their retained range, so they can only be moved, e.g. when the vector of panels grows
+        Panel(const Panel&) = delete;
+        Panel(Panel&&) = default;
+        ~Panel();
+
+        Panel&              operator=(const Panel&) = delete;
+        Panel&              operator=(Panel&&) = default;
 
         void                OnDraw();
         void                AddButton(const std::string& text, const glm::vec2& dimensions);
@@ -42,8 +49,18 @@ namespace FlameUI {
         bool                IsInPanelActivity() const { return m_MainState == MainState::InPanelActivity; }
         bool                IsHoveredOnPanel();
         void                SetFocus(bool value);
-        void                SetZIndex(float z);
-        float               GetZIndex() const { return m_Position.z; }
+        // Occluded panels are completely hidden behind opaque panels in front of them, they record no quads until they are visible again
+        void                SetOccluded(bool isOccluded);
+        bool                IsOccluded() const { return m_IsOccluded; }
+        // Returns true if the panel changed since its quads were last recorded
+        bool                IsDirty() const { return m_IsDirty; }
+        // Returns the bounds of the panel with its drop shadow and of its buttons, which can stick out of a small panel
+        Rect2D              GetBounds() const;
+        // Returns true if every pixel of the panel quad is opaque with the current theme, so that it hides whatever it covers
+        static bool         IsOpaque();
+        // Sets the order of the panel among the other panels, panels with a higher draw order are drawn in front
+        void                SetDrawOrder(uint32_t drawOrder);
+        uint32_t            GetDrawOrder() const { return m_DrawOrder; }
         std::string         GetPanelName() const { return m_PanelName; }
         uint32_t            GetPanelId() const { return m_PanelId; }
         Rect2D              GetPanelRect2D() const { return m_PanelRect2D; }
@@ -51,9 +68,9 @@ namespace FlameUI {
         float               GetHeight() const { return m_Dimensions.y; }
         void                UpdateMetrics(const glm::vec2& position, const glm::vec2& dimensions);
         glm::vec2           GetPosition() const { return m_Position; }
-        void                SetPosition(const glm::vec2& position) { m_Position.x = position.x; m_Position.y = position.y; }
+        void                SetPosition(const glm::vec2& position) { UpdateMetrics(position, m_Dimensions); }
         glm::vec2           GetDimensions() const { return m_Dimensions; }
-        void                SetDimensions(const glm::vec2& dimensions) { m_Dimensions = dimensions; }
+        void                SetDimensions(const glm::vec2& dimensions) { UpdateMetrics(m_Position, dimensions); }
         // Recalculates the bounds of the panel using the 'm_Position' and 'm_Dimensions' variables
         void                InvalidateBounds();
         // Stores the offset of the cursor from the center of the panel when the panel is grabbed to bring continuity in grabbing
@@ -65,10 +82,22 @@ namespace FlameUI {
         std::vector<Button>& GetPanelButtons() { return m_Buttons; }
 
         static std::shared_ptr<Panel> Create(const std::string& title = "Untitled Panel", const glm::vec2& position = glm::vec2{ 0.0f }, const glm::vec2& dimensions = glm::vec2{ 100.0f }, const glm::vec4& color = FL_WHITE);
+    private:
+        // Id of a retained range which becomes invalid in the panel it is moved from, so that the range is destroyed only once
+        struct RetainedRangeId
+        {
+            uint32_t Value = FL_INVALID_RETAINED_RANGE;
+
+            RetainedRangeId() = default;
+            RetainedRangeId(RetainedRangeId&& other) noexcept : Value(std::exchange(other.Value, FL_INVALID_RETAINED_RANGE)) {}
+            RetainedRangeId& operator=(RetainedRangeId&& other) noexcept { std::swap(Value, other.Value); return *this; }
+        };
     private:
         uint32_t                             m_PanelId;
         // Important: m_Position is the position of the center of the panel
         glm::vec3                            m_Position;
+        // Stores the order of the panel among the other panels, from which the z value of 'm_Position' is derived
+        uint32_t                             m_DrawOrder = 0;
         // Stores the dimensions of the panel in pixel units
         glm::vec2                            m_Dimensions;
         // Stores the coordinates of the boundaries of the panel
@@ -80,6 +109,9 @@ namespace FlameUI {
         // Stores the title which will be displayed in the title bar of the panel
         std::string                          m_PanelName;
         bool                                 m_IsFocused = false;
+        bool                                 m_IsOccluded = false;
+        // Set when the panel is entirely outside of the viewport, it records no quads then just like an occluded panel
+        bool                                 m_IsOffscreen = false;
         // Stores the offset of the cursor from the center of the panel, when the panel is grabbed
         glm::vec2                            m_OffsetOfCursorWhenGrabbed;
         DetailedResizeState                  m_DetailedResizeState;
@@ -87,5 +119,11 @@ namespace FlameUI {
         DetailedDockState                    m_DetailedDockState;
         MainState                            m_MainState;
         std::vector<Button>                  m_Buttons;
+        // Range of quads on the GPU which holds the panel and its buttons, recorded again only when the panel is dirty
+        RetainedRangeId                      m_RetainedRangeId;
+        // Set when the metrics, focus, draw order or buttons of the panel change, so that its quads have to be recorded again
+        bool                                 m_IsDirty = true;
+        // Bounds of the panel when its quads were last recorded, damaged along with the new bounds when the panel changes
+        Rect2D                               m_LastDrawnRect2D{ 0.0f };
     };
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "Pipeline.h"
 #include <glm/glm.hpp>
 #include "renderer/Renderer.h"
+#include "renderer/SortKey.h"
 #include "core/Input.h"
+#include <algorithm>
 
 #define FL_NOT_CLICKED -2
 #define FL_CLICKED_ON_NOTHING -1
@@ -10,8 +12,17 @@
 
 namespace FlameUI {
     std::vector<Panel>    Pipeline::s_Panels;
-    std::vector<float>    Pipeline::s_DepthValues;
-    std::vector<uint16_t> Pipeline::s_PanelPositions;
+    uint32_t              Pipeline::s_NextDrawOrder = 1;
+    CullingStats          Pipeline::s_CullingStats;
+    std::vector<uint32_t> Pipeline::s_CullingPanelIndices;
+    std::vector<Rect2D>   Pipeline::s_Occluders;
+    uint32_t              Pipeline::s_CulledPanelCount = 0;
+    uint32_t              Pipeline::s_CulledThemeRevision = 0;
+
+    static bool IsRect2DInside(const Rect2D& inner, const Rect2D& outer)
+    {
+        return inner.l >= outer.l && inner.r <= outer.r && inner.b >= outer.b && inner.t <= outer.t;
+    }
 
     void Pipeline::SubmitPanel(const std::string& title, const glm::vec2& position, const glm::vec2& dimensions, const glm::vec4& color)
     {
@@ -35,20 +46,13 @@ namespace FlameUI {
         const float right = -left;
         const float bottom = -viewportSize.y / Renderer::GetWindowContentScale().y / 2.0f;
         const float top = -bottom;
-        s_DepthValues.resize(s_Panels.size());
-        s_PanelPositions.resize(s_Panels.size());
-        if (s_Panels.size())
-        {
-            float offset = 0.1f / s_Panels.size();
-            float start = 0.1f;
-            for (int16_t i = s_Panels.size() - 1; i >= 0; i--)
-            {
-                float z = start - offset * i;
-                s_DepthValues[i] = z;
-                s_Panels[i].SetZIndex(z);
-                s_PanelPositions[i] = i;
-            }
-        }
+        FL_ASSERT(s_Panels.size() <= FL_MAX_DRAW_ORDER, "{0} panels don't fit in the draw orders, the maximum is {1}!", s_Panels.size(), FL_MAX_DRAW_ORDER);
+
+        // The first panel submitted is drawn in front, draw orders start from 1 so that 0 is below every panel
+        const uint32_t panelCount = (uint32_t)s_Panels.size();
+        for (uint32_t i = 0; i < panelCount; i++)
+            s_Panels[i].SetDrawOrder(panelCount - i);
+        s_NextDrawOrder = panelCount + 1;
     }
 
     void Pipeline::Execute()
@@ -326,7 +330,11 @@ namespace FlameUI {
             panel.UpdateMetrics(panel_position, panel_dimensions);
         }
 
+        // Panels hidden behind opaque panels are left out of the submission below
+        CullOccludedPanels();
+
         // Stage 3: Submiting the final position and dimensions of all panels to the Renderer to draw
+        // Only the panels which changed are recorded again, the rest are still resident on the GPU
         for (auto& panel : s_Panels)
             panel.OnDraw();
     }
@@ -334,7 +342,7 @@ namespace FlameUI {
     void Pipeline::InvalidateFocus()
     {
         GLFWwindow* window = Renderer::GetUserGLFWwindow();
-        float z_index = -0.95f;
+        uint32_t top_draw_order = 0;
         int panel_index = FL_NOT_CLICKED;
         static int last_panel_index = FL_NOT_CLICKED;
         static bool is_grabbed_outside = false;
@@ -347,13 +355,13 @@ namespace FlameUI {
         if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
         {
             panel_index = FL_CLICKED_ON_NOTHING;
-            for (uint16_t i = 0; i < s_Panels.size(); i++)
+            for (uint32_t i = 0; i < s_Panels.size(); i++)
             {
                 if (s_Panels[i].IsHoveredOnPanel())
                 {
-                    if (z_index < s_Panels[i].GetZIndex())
+                    if (top_draw_order < s_Panels[i].GetDrawOrder())
                     {
-                        z_index = s_Panels[i].GetZIndex();
+                        top_draw_order = s_Panels[i].GetDrawOrder();
                         panel_index = i;
                     }
                 }
@@ -373,7 +381,7 @@ namespace FlameUI {
                 {
                     last_panel_index = panel_index;
 
-                    InvalidatePanelPositions(panel_index);
+                    BringPanelToFront(panel_index);
                     s_Panels[panel_index].SetFocus(true);
 
                     first_time = false;
@@ -381,7 +389,7 @@ namespace FlameUI {
 
                 if ((last_panel_index != FL_CLICKED_ON_NOTHING) && (panel_index != last_panel_index) && s_Panels[last_panel_index].GetMainState() == MainState::None)
                 {
-                    InvalidatePanelPositions(panel_index);
+                    BringPanelToFront(panel_index);
                     s_Panels[last_panel_index].SetFocus(false);
                     s_Panels[panel_index].SetFocus(true);
 
@@ -390,7 +398,7 @@ namespace FlameUI {
 
                 if ((last_panel_index == FL_CLICKED_ON_NOTHING) && (!is_grabbed_outside))
                 {
-                    InvalidatePanelPositions(panel_index);
+                    BringPanelToFront(panel_index);
                     s_Panels[panel_index].SetFocus(true);
 
                     last_panel_index = panel_index;
@@ -411,16 +419,78 @@ namespace FlameUI {
         }
     }
 
-    void Pipeline::InvalidatePanelPositions(int current_panel_index)
+    void Pipeline::BringPanelToFront(uint32_t panelIndex)
+    {
+        if (s_Panels[panelIndex].GetDrawOrder() == s_NextDrawOrder - 1)
+            return;
+        if (s_NextDrawOrder > FL_MAX_DRAW_ORDER)
+            CompactDrawOrders();
+        s_Panels[panelIndex].SetDrawOrder(s_NextDrawOrder++);
+    }
+
+    void Pipeline::CompactDrawOrders()
     {
-        for (uint16_t i = 0; i < s_PanelPositions.size(); i++)
+        std::vector<uint32_t> panelIndices(s_Panels.size());
+        for (uint32_t i = 0; i < panelIndices.size(); i++)
+            panelIndices[i] = i;
+        std::sort(panelIndices.begin(), panelIndices.end(), [](uint32_t a, uint32_t b) { return s_Panels[a].GetDrawOrder() < s_Panels[b].GetDrawOrder(); });
+
+        for (uint32_t i = 0; i < panelIndices.size(); i++)
+            s_Panels[panelIndices[i]].SetDrawOrder(i + 1);
+        s_NextDrawOrder = (uint32_t)panelIndices.size() + 1;
+    }
+
+    void Pipeline::CullOccludedPanels()
+    {
+        // Panels only become dirty when they move, resize or change their draw order, focus or occlusion, which is what the culling depends on
+        const uint32_t themeRevision = Renderer::GetThemeRevision();
+        bool isAnyPanelDirty = std::any_of(s_Panels.begin(), s_Panels.end(), [](const Panel& panel) { return panel.IsDirty(); });
+        if (!isAnyPanelDirty && s_CulledPanelCount == (uint32_t)s_Panels.size() && s_CulledThemeRevision == themeRevision)
+            return;
+        s_CulledPanelCount = (uint32_t)s_Panels.size();
+        s_CulledThemeRevision = themeRevision;
+
+        // Visit the panels front to back, so that each one is only tested against the opaque panels in front of it
+        auto& panelIndices = s_CullingPanelIndices;
+        panelIndices.resize(s_Panels.size());
+        for (uint32_t i = 0; i < panelIndices.size(); i++)
+            panelIndices[i] = i;
+        std::sort(panelIndices.begin(), panelIndices.end(), [](uint32_t a, uint32_t b) { return s_Panels[a].GetDrawOrder() > s_Panels[b].GetDrawOrder(); });
+
+        // All the panels share the theme colors, so either all of them hide what they cover or none of them do
+        const bool arePanelsOpaque = Panel::IsOpaque();
+        auto& occluders = s_Occluders;
+        occluders.clear();
+        CullingStats cullingStats;
+        for (uint32_t panelIndex : panelIndices)
         {
-            if (s_PanelPositions[i] < s_PanelPositions[current_panel_index])
-                s_PanelPositions[i]++;
+            Panel& panel = s_Panels[panelIndex];
+            // The buttons of moved panels are placed here rather than in OnDraw, so that the culling sees where they are this frame
+            if (panel.IsDirty())
+                panel.InvalidateButtonPos();
+
+            auto isHidden = [&occluders](const Rect2D& rect) {
+                return std::any_of(occluders.begin(), occluders.end(), [&rect](const Rect2D& occluder) { return IsRect2DInside(rect, occluder); });
+            };
+
+            bool isPanelOccluded = isHidden(panel.GetBounds());
+            panel.SetOccluded(isPanelOccluded);
+            for (auto& button : panel.GetPanelButtons())
+            {
+                bool isButtonOccluded = isPanelOccluded || isHidden(button.GetButtonInfo().buttonRect2D);
+                button.SetOccluded(isButtonOccluded);
+                cullingStats.culledButtons += isButtonOccluded;
+            }
+
+            if (isPanelOccluded)
+                cullingStats.culledPanels++;
+            else if (arePanelsOpaque)
+                occluders.push_back(panel.GetPanelRect2D());
         }
-        s_PanelPositions[current_panel_index] = 0;
-        for (uint16_t i = 0; i < s_Panels.size(); i++)
-            s_Panels[i].SetZIndex(s_DepthValues[s_PanelPositions[i]]);
+
+        if (cullingStats.culledPanels != s_CullingStats.culledPanels || cullingStats.culledButtons != s_CullingStats.culledButtons)
+            FL_INFO("Occlusion culling: {0} panels and {1} buttons hidden behind opaque panels", cullingStats.culledPanels, cullingStats.culledButtons);
+        s_CullingStats = cullingStats;
     }
 
     Metrics Pipeline::GetPanelMetricsForResizingLeft(const Metrics& panelMetrics, const glm::vec2& cursorPosition)
@@ -3,6 +3,8 @@
 
 namespace FlameUI {
     struct Metrics { glm::vec2 position, dimensions; };
+    // Number of panels and buttons of the last frame which weren't drawn, because they were hidden behind opaque panels
+    struct CullingStats { uint32_t culledPanels = 0, culledButtons = 0; };
 
     class Pipeline
     {
@@ -13,9 +15,17 @@ namespace FlameUI {
         static void Execute();
 
         static std::vector<Panel>& GetPanels() { return s_Panels; }
+        static const CullingStats& GetCullingStats() { return s_CullingStats; }
     private:
         static void InvalidateFocus();
-        static void InvalidatePanelPositions(int current_panel_index);
+        // Draws the panel in front of all the other panels, which only changes the draw order of that panel
+        static void BringPanelToFront(uint32_t panelIndex);
+        // Numbers the panels again from 1 keeping their order, once the draw orders handed out by 'BringPanelToFront' run out
+        static void CompactDrawOrders();
+        // Marks the panels and buttons which are completely covered by a single opaque panel in front of them as occluded.
+        // Conservative, as a panel hidden only by the union of several panels is still drawn.
+        // Only runs again when a panel changed or the theme was replaced, otherwise the occlusion of the last frame still holds
+        static void CullOccludedPanels();
         static Metrics GetPanelMetricsForResizingLeft(const Metrics& panelMetrics, const glm::vec2& cursorPosition);
         static Metrics GetPanelMetricsForResizingRight(const Metrics& panelMetrics, const glm::vec2& cursorPosition);
         static Metrics GetPanelMetricsForResizingBottom(const Metrics& panelMetrics, const glm::vec2& cursorPosition);
@@ -24,7 +34,14 @@ namespace FlameUI {
         constexpr static float MIN_PANEL_WIDTH = 20.0f, MIN_PANEL_HEIGHT = TITLE_BAR_HEIGHT + 10.0f;
     private:
         static std::vector<Panel>     s_Panels;
-        static std::vector<float>     s_DepthValues;
-        static std::vector<uint16_t>  s_PanelPositions;
+        // Draw order which the next panel brought to the front gets
+        static uint32_t               s_NextDrawOrder;
+        static CullingStats           s_CullingStats;
+        // Scratch storage of the culling, kept to avoid allocating it again whenever the culling runs
+        static std::vector<uint32_t>  s_CullingPanelIndices;
+        static std::vector<Rect2D>    s_Occluders;
+        // Panel count and theme revision when the culling last ran, a change of either makes it run again
+        static uint32_t               s_CulledPanelCount;
+        static uint32_t               s_CulledThemeRevision;
     };
 }
\ No newline at end of file
@@ -1,14 +1,9 @@
 #include "Text.h"
+#include "renderer/Renderer.h"
 
 namespace FlameUI {
-    TextHelper::TextHelper(const std::string& text, std::unordered_map<char, flame::character>& characters, float fontScale)
-        : m_Text(text), m_Dimensions(0.0f)
+    TextHelper::TextHelper(const std::string& text, float fontScale)
+        : m_Text(text), m_Dimensions(Renderer::GetTextDimensions(text, fontScale))
     {
-        for (std::string::const_iterator it = text.begin(); it != text.end(); it++)
-        {
-            if (it != text.end() - 1)
-                m_Dimensions.x += characters[*it].advance * fontScale + 1.0f;
-            m_Dimensions.x += characters[*it].size.x * fontScale;
-        }
     }
 }
\ No newline at end of file
@@ -6,10 +6,13 @@
 namespace flame {
     struct character
     {
-        uint32_t   textureId;  // ID handle of the glyph texture
+        uint32_t   textureId;  // ID handle of the glyph atlas texture containing the glyph
         glm::vec2  size;       // Size of glyph
         glm::vec2  bearing;    // Offset from baseline to left/top of glyph
         double     advance;    // Offset to advance to next glyph
+        glm::vec2  uvMin;      // Texture coordinates of the bottom left corner of the glyph in the atlas
+        glm::vec2  uvMax;      // Texture coordinates of the top right corner of the glyph in the atlas
+        uint32_t   atlasPage;  // Page of the glyph atlas, i.e. the layer of the array texture, containing the glyph
     };
 }
 
@@ -17,7 +20,8 @@ namespace FlameUI {
     class TextHelper
     {
     public:
-        TextHelper(const std::string& text, std::unordered_map<char, flame::character>& characters, float fontScale);
+        /// Measures the text using the cached layout of the `Renderer`, so it matches the way the text is drawn
+        TextHelper(const std::string& text, float fontScale);
         ~TextHelper() = default;
 
         float          GetTextWidth()                   const { return m_Dimensions.x; }
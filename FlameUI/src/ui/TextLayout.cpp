@@ -0,0 +1,182 @@
+#include "TextLayout.h"
+#include <cstdint>
+#include <algorithm>
+#include "utils/Hash.h"
+#include "utils/UTF8.h"
+
+namespace FlameUI {
+    /// Stands for a '\n' in the resolved glyph metrics indices of a string, the glyphs which the font has no glyph for are left out completely
+    static constexpr int32_t s_LineBreakIndex = -1;
+    static constexpr int32_t s_UnresolvedIndex = -2;
+
+    TextLayoutCache::TextLayoutCache(const GlyphProvider& glyphProvider, uint64_t fontId, float ascenderY, float descenderY)
+        : m_GlyphProvider(glyphProvider), m_FontId(fontId), m_AscenderY(ascenderY), m_DescenderY(descenderY), m_FrameIndex(0)
+    {
+        m_AsciiGlyphMetricsIndices.fill(s_UnresolvedIndex);
+    }
+
+    std::shared_ptr<const TextLayout> TextLayoutCache::GetLayout(const std::string& text, float scale, float maxWidth)
+    {
+        uint64_t key = HashBytes(text.data(), text.size());
+        key = HashBytes(&scale, sizeof(float), key);
+        key = HashBytes(&maxWidth, sizeof(float), key);
+        key = HashBytes(&m_FontId, sizeof(uint64_t), key);
+
+        auto entryIt = m_Layouts.find(key);
+        if (entryIt != m_Layouts.end() && entryIt->second.Scale == scale && entryIt->second.MaxWidth == maxWidth && entryIt->second.Text == text)
+        {
+            entryIt->second.LastUsedFrame = m_FrameIndex;
+            return entryIt->second.Layout;
+        }
+
+        std::shared_ptr<const TextLayout> layout = CreateLayout(text, scale, maxWidth);
+        m_Layouts[key] = CacheEntry{ text, scale, maxWidth, m_FrameIndex, layout };
+        return layout;
+    }
+
+    void TextLayoutCache::OnFrameEnd()
+    {
+        if (m_Layouts.size() > MAX_CACHED_TEXT_LAYOUTS)
+        {
+            for (auto it = m_Layouts.begin(); it != m_Layouts.end();)
+            {
+                if (it->second.LastUsedFrame < m_FrameIndex)
+                    it = m_Layouts.erase(it);
+                else
+                    it++;
+            }
+        }
+        m_FrameIndex++;
+    }
+
+    int32_t TextLayoutCache::GetGlyphMetricsIndex(uint32_t codepoint)
+    {
+        int32_t* index;
+        if (codepoint < m_AsciiGlyphMetricsIndices.size())
+            index = &m_AsciiGlyphMetricsIndices[codepoint];
+        else
+            index = &m_GlyphMetricsIndices.try_emplace(codepoint, s_UnresolvedIndex).first->second;
+
+        if (*index == s_UnresolvedIndex)
+        {
+            const flame::character* character = m_GlyphProvider(codepoint);
+            if (character)
+            {
+                *index = (int32_t)m_GlyphMetrics.size();
+                m_GlyphMetrics.push_back({ codepoint, (float)character->advance, character->bearing, character->size });
+            }
+            else
+                *index = -1;
+        }
+        return *index;
+    }
+
+    std::shared_ptr<TextLayout> TextLayoutCache::CreateLayout(const std::string& text, float scale, float maxWidth)
+    {
+        // Resolve all the code points to glyph metrics first, the line breaking and positioning below only touch the flat metrics table
+        std::vector<int32_t> glyphMetricsIndices;
+        glyphMetricsIndices.reserve(text.size());
+
+        const char* it = text.data();
+        const char* end = text.data() + text.size();
+        while (it != end)
+        {
+            uint32_t codepoint = DecodeUTF8(it, end);
+            if (codepoint == '\n')
+            {
+                glyphMetricsIndices.push_back(s_LineBreakIndex);
+                continue;
+            }
+
+            int32_t index = GetGlyphMetricsIndex(codepoint);
+            if (index >= 0)
+                glyphMetricsIndices.push_back(index);
+        }
+
+        // Break the text into lines, at every '\n' and, when wrapping, after the last space which keeps the line within `maxWidth`.
+        // Words longer than `maxWidth` are broken between two glyphs
+        std::vector<std::pair<size_t, size_t>> lineRanges;
+        size_t lineBegin = 0;
+        size_t lastSpace = SIZE_MAX;
+        float penX = 0.0f;
+        for (size_t i = 0; i < glyphMetricsIndices.size(); i++)
+        {
+            if (glyphMetricsIndices[i] == s_LineBreakIndex)
+            {
+                lineRanges.emplace_back(lineBegin, i);
+                lineBegin = i + 1;
+                lastSpace = SIZE_MAX;
+                penX = 0.0f;
+                continue;
+            }
+
+            const GlyphMetrics& metrics = m_GlyphMetrics[glyphMetricsIndices[i]];
+            if (maxWidth > 0.0f && i > lineBegin && metrics.Codepoint != ' ' && penX + (metrics.Bearing.x + metrics.Size.x) * scale > maxWidth)
+            {
+                if (lastSpace != SIZE_MAX)
+                {
+                    lineRanges.emplace_back(lineBegin, lastSpace);
+                    lineBegin = lastSpace + 1;
+                }
+                else
+                {
+                    lineRanges.emplace_back(lineBegin, i);
+                    lineBegin = i;
+                }
+
+                lastSpace = SIZE_MAX;
+                penX = 0.0f;
+                for (size_t j = lineBegin; j < i; j++)
+                    penX += m_GlyphMetrics[glyphMetricsIndices[j]].Advance * scale + 1.0f;
+            }
+
+            if (metrics.Codepoint == ' ')
+                lastSpace = i;
+            penX += metrics.Advance * scale + 1.0f;
+        }
+        lineRanges.emplace_back(lineBegin, glyphMetricsIndices.size());
+
+        // Position the glyphs, the origin of the layout is the bottom of the descender of the first line and lines go downwards
+        auto layout = std::make_shared<TextLayout>();
+        layout->glyphs.reserve(glyphMetricsIndices.size());
+        layout->lines.reserve(lineRanges.size());
+
+        float lineHeight = (m_AscenderY - m_DescenderY) * scale;
+        float lowestY = 0.0f, highestY = 0.0f;
+        for (size_t lineIndex = 0; lineIndex < lineRanges.size(); lineIndex++)
+        {
+            LayoutLine line{ (uint32_t)layout->glyphs.size(), 0, 0.0f };
+            float baselineY = -m_DescenderY * scale - lineIndex * lineHeight;
+            penX = 0.0f;
+
+            for (size_t i = lineRanges[lineIndex].first; i < lineRanges[lineIndex].second; i++)
+            {
+                const GlyphMetrics& metrics = m_GlyphMetrics[glyphMetricsIndices[i]];
+
+                LayoutGlyph glyph;
+                glyph.codepoint = metrics.Codepoint;
+                glyph.position = { penX + metrics.Bearing.x * scale, baselineY - (metrics.Size.y - metrics.Bearing.y) * scale };
+                glyph.size = metrics.Size * scale;
+
+                if (layout->glyphs.empty())
+                {
+                    lowestY = glyph.position.y;
+                    highestY = glyph.position.y + glyph.size.y;
+                }
+                lowestY = std::min(lowestY, glyph.position.y);
+                highestY = std::max(highestY, glyph.position.y + glyph.size.y);
+                line.width = glyph.position.x + glyph.size.x;
+
+                layout->glyphs.push_back(glyph);
+                penX += metrics.Advance * scale + 1.0f;
+            }
+
+            line.glyphCount = (uint32_t)layout->glyphs.size() - line.firstGlyph;
+            layout->dimensions.x = std::max(layout->dimensions.x, line.width);
+            layout->lines.push_back(line);
+        }
+        layout->dimensions.y = highestY - lowestY;
+
+        return layout;
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "ui/Text.h"
+
+/// Number of text layouts kept in the cache, layouts which weren't used in the last frame are removed once the cache grows beyond this
+#define MAX_CACHED_TEXT_LAYOUTS 1024
+
+namespace FlameUI {
+    /// A glyph positioned by the text layout engine, in pixels relative to the position the text is drawn at
+    struct LayoutGlyph
+    {
+        uint32_t  codepoint;
+        /// Bottom left corner of the glyph quad
+        glm::vec2 position;
+        /// Dimensions of the glyph quad
+        glm::vec2 size;
+    };
+
+    /// A line of the text layout, which is a run of consecutive glyphs
+    struct LayoutLine
+    {
+        uint32_t firstGlyph, glyphCount;
+        /// Distance from the left edge of the layout to the right edge of the last glyph of the line
+        float    width;
+    };
+
+    /// Result of laying out a string at a certain scale, immutable once it is created
+    struct TextLayout
+    {
+        std::vector<LayoutGlyph> glyphs;
+        std::vector<LayoutLine>  lines;
+        /// Width of the widest line and the height from the lowest to the highest glyph, in pixels
+        glm::vec2                dimensions{ 0.0f };
+    };
+
+    /// Lays out UTF-8 strings into lines of positioned glyphs, breaking lines at '\n' and wrapping them at spaces when a maximum width is given.
+    /// Layouts are cached by the hash of the string, the scale, the maximum width and the font, so static labels are only laid out once
+    class TextLayoutCache
+    {
+    public:
+        /// Returns the glyph of a code point or nullptr if the font has no such glyph, only called the first time a code point is seen
+        using GlyphProvider = std::function<const flame::character*(uint32_t codepoint)>;
+    public:
+        TextLayoutCache(const GlyphProvider& glyphProvider, uint64_t fontId, float ascenderY, float descenderY);
+        ~TextLayoutCache() = default;
+
+        /// Returns the cached layout of the text or lays it out, a `maxWidth` of 0 disables wrapping
+        std::shared_ptr<const TextLayout> GetLayout(const std::string& text, float scale, float maxWidth = 0.0f);
+        /// Removes the layouts which weren't used in the last frame if the cache holds more than `MAX_CACHED_TEXT_LAYOUTS` of them
+        void OnFrameEnd();
+    private:
+        /// Metrics of a glyph needed for laying it out, independent of where the glyph is stored in the glyph atlas
+        struct GlyphMetrics
+        {
+            uint32_t  Codepoint;
+            float     Advance;
+            glm::vec2 Bearing;
+            glm::vec2 Size;
+        };
+        struct CacheEntry
+        {
+            std::string                       Text;
+            float                             Scale, MaxWidth;
+            uint64_t                          LastUsedFrame;
+            std::shared_ptr<const TextLayout> Layout;
+        };
+    private:
+        /// Returns the index of the glyph metrics in `m_GlyphMetrics`, or -1 if the font has no glyph for the code point
+        int32_t GetGlyphMetricsIndex(uint32_t codepoint);
+        std::shared_ptr<TextLayout> CreateLayout(const std::string& text, float scale, float maxWidth);
+    private:
+        GlyphProvider                                           m_GlyphProvider;
+        uint64_t                                                m_FontId;
+        float                                                   m_AscenderY, m_DescenderY;
+        /// Flat table of the metrics of every glyph seen so far, layouts are measured over this instead of looking up each glyph
+        std::vector<GlyphMetrics>                               m_GlyphMetrics;
+        /// Indices into `m_GlyphMetrics` of the ASCII code points, -2 until the code point is first seen
+        std::array<int32_t, 128>                                m_AsciiGlyphMetricsIndices;
+        std::unordered_map<uint32_t, int32_t>                   m_GlyphMetricsIndices;
+        /// Cached layouts by the hash of their key, the key is stored in the entry as well to rule out hash collisions
+        std::unordered_map<uint64_t, CacheEntry>                m_Layouts;
+        uint64_t                                                m_FrameIndex;
+    };
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace FlameUI {
+    constexpr uint64_t FL_FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FL_FNV1A_64_PRIME = 1099511628211ull;
+
+    /// 64-bit FNV-1a hash of `size` bytes, pass the result of a previous call as `hash` to hash multiple buffers together
+    inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FL_FNV1A_64_OFFSET_BASIS)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FL_FNV1A_64_PRIME;
+        }
+        return hash;
+    }
+
+    /// 64-bit FNV-1a hash of a null terminated string, evaluated at compile time for string literals in constant expressions
+    constexpr uint64_t HashString(const char* str, uint64_t hash = FL_FNV1A_64_OFFSET_BASIS)
+    {
+        for (; *str; str++)
+        {
+            hash ^= (uint8_t)*str;
+            hash *= FL_FNV1A_64_PRIME;
+        }
+        return hash;
+    }
+
+    /// Identifier of a named resource, e.g. a uniform, made from the hash of its name so that looking it up needs no string.
+    /// Declare it `constexpr` to hash the name at compile time, the name itself is only kept to be passed to OpenGL and for logging
+    struct HashedId
+    {
+        uint64_t    Hash;
+        const char* Name;
+
+        constexpr HashedId(const char* name)
+            : Hash(HashString(name)), Name(name)
+        {
+        }
+    };
+}
@@ -0,0 +1,72 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace FlameUI {
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& filePath)
+        : m_Data(nullptr), m_Size(0), m_FileHandle(INVALID_HANDLE_VALUE), m_MappingHandle(nullptr)
+    {
+        m_FileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_FileHandle == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_FileHandle, &fileSize) || fileSize.QuadPart == 0)
+            return;
+
+        m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_MappingHandle)
+            return;
+
+        m_Data = (const uint8_t*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (m_Data)
+            m_Size = (size_t)fileSize.QuadPart;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_MappingHandle)
+            CloseHandle(m_MappingHandle);
+        if (m_FileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(m_FileHandle);
+    }
+#else
+    MappedFile::MappedFile(const std::string& filePath)
+        : m_Data(nullptr), m_Size(0)
+    {
+        int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+        if (fileDescriptor == -1)
+            return;
+
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) == 0 && fileStat.st_size > 0)
+        {
+            void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            if (data != MAP_FAILED)
+            {
+                m_Data = (const uint8_t*)data;
+                m_Size = (size_t)fileStat.st_size;
+            }
+        }
+
+        // The mapping stays valid after the file descriptor is closed
+        close(fileDescriptor);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            munmap((void*)m_Data, m_Size);
+    }
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+namespace FlameUI {
+    /// Class which maps a whole file into memory for reading, the mapping lives as long as the object
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::string& filePath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /// Returns false if the file doesn't exist, is empty or couldn't be mapped
+        bool           IsOpen() const { return m_Data != nullptr; }
+        const uint8_t* GetData() const { return m_Data; }
+        size_t         GetSize() const { return m_Size; }
+    private:
+        const uint8_t* m_Data;
+        size_t         m_Size;
+#ifdef _WIN32
+        void*          m_FileHandle;
+        void*          m_MappingHandle;
+#endif
+    };
+}
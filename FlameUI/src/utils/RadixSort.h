@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace FlameUI {
+    /// Outputs into `indices` the order which sorts `keys` ascending, equal keys keep their order.
+    /// Sorts one byte per pass starting from the least significant one, skipping the bytes which are the same in every key.
+    /// `scratch` is working memory which is kept by the caller so that sorting every frame doesn't allocate
+    inline void RadixSortIndices(const uint64_t* keys, uint32_t count, std::vector<uint32_t>& indices, std::vector<uint32_t>& scratch)
+    {
+        indices.resize(count);
+        scratch.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+            indices[i] = i;
+
+        // The histograms of all 8 bytes are built in a single pass over the keys
+        std::array<std::array<uint32_t, 256>, 8> histograms{};
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t byte = 0; byte < 8; byte++)
+                histograms[byte][(keys[i] >> (byte * 8)) & 0xFF]++;
+        }
+
+        for (uint32_t byte = 0; byte < 8; byte++)
+        {
+            auto& histogram = histograms[byte];
+            if (histogram[(keys[0] >> (byte * 8)) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (auto& bucket : histogram)
+            {
+                uint32_t bucketSize = bucket;
+                bucket = offset;
+                offset += bucketSize;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t index = indices[i];
+                scratch[histogram[(keys[index] >> (byte * 8)) & 0xFF]++] = index;
+            }
+            indices.swap(scratch);
+        }
+    }
+}
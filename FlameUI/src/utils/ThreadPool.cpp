@@ -0,0 +1,67 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace FlameUI {
+    ThreadPool::ThreadPool(uint32_t threadCount)
+        : m_PendingTaskCount(0), m_IsStopping(false)
+    {
+        if (!threadCount)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        m_Workers.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+            m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    void ThreadPool::Submit(const std::function<void()>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push(task);
+            m_PendingTaskCount++;
+        }
+        m_TaskAvailable.notify_one();
+    }
+
+    void ThreadPool::Wait()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_AllTasksDone.wait(lock, [this]() { return m_PendingTaskCount == 0; });
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_TaskAvailable.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+                if (m_IsStopping && m_Tasks.empty())
+                    return;
+
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop();
+            }
+
+            task();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_PendingTaskCount--;
+            if (!m_PendingTaskCount)
+                m_AllTasksDone.notify_all();
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_IsStopping = true;
+        }
+        m_TaskAvailable.notify_all();
+
+        for (auto& worker : m_Workers)
+            worker.join();
+    }
+}
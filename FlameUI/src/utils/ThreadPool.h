@@ -0,0 +1,37 @@
+#pragma once
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace FlameUI {
+    /// A fixed number of worker threads which execute the submitted tasks in FIFO order
+    class ThreadPool
+    {
+    public:
+        /// Creates `threadCount` worker threads, a count of 0 uses one thread per hardware thread
+        ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        /// Queues the task to be executed by the next free worker thread
+        void     Submit(const std::function<void()>& task);
+        /// Blocks the calling thread until all the submitted tasks have finished executing
+        void     Wait();
+        uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size(); }
+    private:
+        void WorkerLoop();
+    private:
+        std::vector<std::thread>          m_Workers;
+        std::queue<std::function<void()>> m_Tasks;
+        std::mutex                        m_Mutex;
+        /// Signalled when a task is submitted or when the pool is being destroyed
+        std::condition_variable           m_TaskAvailable;
+        /// Signalled when the last queued or running task finishes
+        std::condition_variable           m_AllTasksDone;
+        /// Number of tasks that are either queued or being executed
+        uint32_t                          m_PendingTaskCount;
+        bool                              m_IsStopping;
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+namespace FlameUI {
+    /// Code point that invalid UTF-8 sequences are decoded to
+    constexpr uint32_t FL_UNICODE_REPLACEMENT_CHARACTER = 0xFFFD;
+
+    /// Decodes the UTF-8 sequence starting at `it` and advances `it` past it, `it` must not be equal to `end`.
+    /// Invalid, overlong or truncated sequences decode to U+FFFD and only consume their first byte
+    inline uint32_t DecodeUTF8(const char*& it, const char* end)
+    {
+        uint8_t leadByte = (uint8_t)*it++;
+
+        // ASCII fast path, which is all that most UI text ever needs
+        if (leadByte < 0x80)
+            return leadByte;
+
+        uint32_t continuationByteCount, codepoint, minimumCodepoint;
+        if ((leadByte & 0xE0) == 0xC0)
+        {
+            continuationByteCount = 1;
+            codepoint = leadByte & 0x1F;
+            minimumCodepoint = 0x80;
+        }
+        else if ((leadByte & 0xF0) == 0xE0)
+        {
+            continuationByteCount = 2;
+            codepoint = leadByte & 0x0F;
+            minimumCodepoint = 0x800;
+        }
+        else if ((leadByte & 0xF8) == 0xF0)
+        {
+            continuationByteCount = 3;
+            codepoint = leadByte & 0x07;
+            minimumCodepoint = 0x10000;
+        }
+        else
+            return FL_UNICODE_REPLACEMENT_CHARACTER;
+
+        if ((uint32_t)(end - it) < continuationByteCount)
+            return FL_UNICODE_REPLACEMENT_CHARACTER;
+
+        for (uint32_t i = 0; i < continuationByteCount; i++)
+        {
+            uint8_t continuationByte = (uint8_t)it[i];
+            if ((continuationByte & 0xC0) != 0x80)
+                return FL_UNICODE_REPLACEMENT_CHARACTER;
+            codepoint = (codepoint << 6) | (continuationByte & 0x3F);
+        }
+
+        if (codepoint < minimumCodepoint || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+            return FL_UNICODE_REPLACEMENT_CHARACTER;
+
+        it += continuationByteCount;
+        return codepoint;
+    }
+}
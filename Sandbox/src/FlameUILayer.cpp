@@ -13,6 +13,8 @@ namespace Flameberry {
 
         themeInfo.buttonColor = { 0.26f, 0.59f, 0.98f, 0.40f };
         themeInfo.buttonHoveredColor = { 0.26f, 0.59f, 0.98f, 1.00f };
+        themeInfo.buttonPressedColor = { 0.06f, 0.53f, 0.98f, 1.00f };
+        themeInfo.windowBgColor = { 50.0f / 255.0f, 50.0f / 255.0f, 50.0f / 255.0f, 1.0f };
 
         FlameUI::RendererInitInfo rendererInitInfo{};
         rendererInitInfo.userWindow = SandboxApp::GetApp()->GetMainWindow().GetGLFWwindow();